@@ -0,0 +1,10 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#pragma once
+#include "defs.h"
+const char* bench_requested(void); int run_bench(const char *name);
+void bench_parse(void); void bench_idle(void); void bench_seq(void); void bench_maglev(void); void bench_egress(void); void bench_stage(void);
@@ -0,0 +1,16 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#pragma once
+#include "defs.h"
+#define MAX_SINKS 4u
+#define SINK_BURST 256u
+enum egress_mode_e { EGRESS_SINK = 0, EGRESS_DIRECT = 1 };
+extern int g_egress_mode;
+extern unsigned g_nb_sinks, g_sink_cores[MAX_SINKS];
+extern volatile uint64_t g_sink_rx[MAX_SINKS];
+void egress_config_from_env(void); const char* egress_mode_name(void);
+void egress_free_bulk(struct rte_mbuf **pkts, unsigned n);
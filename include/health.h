@@ -0,0 +1,26 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#pragma once
+#include "defs.h"
+#define HEALTH_POLL_US 500u
+#define STALL_DEFAULT_US 2000u
+#define HEALTH_PROBATION_POLLS 10u
+#define HEALTH_RETURN_STEPS 4u
+#define HEALTH_STEP_MS 50u
+enum worker_health_e { WK_HEALTHY = 0, WK_QUARANTINED, WK_RECOVERING };
+/* Bumped by each worker once per poll loop, so the control core can tell a thread that stopped running from one that runs but makes no progress. */
+typedef struct worker_beat { volatile uint64_t beat; } __rte_cache_aligned worker_beat;
+extern worker_beat g_worker_beat[16];
+extern volatile uint8_t g_worker_health[16];
+extern int g_stall_inject_wi;
+uint32_t stall_us_from_env(void); const char* worker_health_name(unsigned wi);
+void health_init(void);
+void health_tick(void);
+void health_inject_stall(unsigned idx);
+static inline void worker_heartbeat(unsigned idx){ g_worker_beat[idx].beat++; if(unlikely((int)idx==g_stall_inject_wi)) health_inject_stall(idx); }
+/* Only healthy workers may receive buckets (evacuation targets, greedy reshaper). */
+static inline bool worker_usable(unsigned wi){ return g_worker_health[wi]==WK_HEALTHY; }
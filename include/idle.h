@@ -0,0 +1,27 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#pragma once
+#include "defs.h"
+#define IDLE_SPIN_POLLS 64u
+#define IDLE_MONITOR_POLLS 1024u
+#define IDLE_SLEEP_POLLS 4096u
+#define IDLE_MONITOR_US 50u
+enum idle_policy_e { IDLE_SPIN = 0, IDLE_PAUSE, IDLE_MONITOR, IDLE_FREQ, IDLE_SLEEP, IDLE_ADAPTIVE, IDLE_POLICY_COUNT };
+/* Per-lcore TSC accounting: busy = polls that returned work, idle = empty polls + waits, deep = idle spent in monitor/sleep/min-freq.
+ * park_until is the TSC deadline of a deliberate sleep/monitor wait in progress (0 = polling), so a stall watchdog can tell the two apart. */
+typedef struct lcore_cycles { volatile uint64_t busy, idle, deep, park_until; } __rte_cache_aligned lcore_cycles;
+extern lcore_cycles g_lcore_cycles[RTE_MAX_LCORE];
+typedef struct idle_state { uint64_t last, deep_since, monitor_cyc, sleep_cyc; uint32_t empty_run, sleep_us; uint8_t policy, freq_low, power_ok, monitor_ok; unsigned lcore; lcore_cycles *acct; } idle_state;
+int idle_policy_from_env(void); const char* idle_policy_name(int policy);
+void idle_power_setup(void); void idle_init(idle_state *st, int policy); void idle_fini(idle_state *st);
+void idle_wait(idle_state *st, const struct rte_ring *r); void idle_wake(idle_state *st);
+double lcore_util_pct(unsigned lcore, uint64_t *prev_busy, uint64_t *prev_idle);
+static inline void idle_mark(idle_state *st, bool busy){ uint64_t now=rte_get_tsc_cycles(); uint64_t d=now-st->last; st->last=now; if(busy) st->acct->busy+=d; else st->acct->idle+=d; }
+/* Call right after a poll that returned work (restores frequency, ends the empty run) ... */
+static inline void idle_resume(idle_state *st){ if(unlikely(st->empty_run)) idle_wake(st); }
+/* ... and once that work has been processed. */
+static inline void idle_account(idle_state *st){ idle_mark(st,true); }
@@ -0,0 +1,22 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#pragma once
+#include "defs.h"
+#define MAGLEV_DEFAULT_SIZE 65537u
+#define MAGLEV_MAX_SIZE (1u<<22)
+#define MAGLEV_FREE 0xFFu
+extern bool g_maglev_on;
+extern uint8_t *g_maglev;
+extern uint32_t g_maglev_size;
+extern uint16_t g_maglev_weight[16];
+bool maglev_enabled(void); uint32_t maglev_round_size(uint32_t m); uint32_t maglev_size_from_env(void); void maglev_weights_from_env(uint16_t *w);
+void maglev_init(uint32_t size, const uint16_t *weights);
+void maglev_build(const uint16_t *weights);
+unsigned maglev_set_weight(unsigned wi, uint16_t w); unsigned maglev_set_ramp(unsigned wi, unsigned pct);
+void maglev_counts(unsigned *cnt);
+/* Multiply-shift range reduction: no division on the lookup path, any (prime) table size. */
+static inline uint16_t maglev_pick(uint32_t h){ return (uint16_t)g_maglev[((uint64_t)h*g_maglev_size)>>32]; }
@@ -0,0 +1,16 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#pragma once
+#include "defs.h"
+#define FKEY_MAX 40u
+enum l3_e { L3_NONE = 0, L3_IPV4 = 4, L3_IPV6 = 6 };
+enum tun_e { TUN_NONE = 0, TUN_VXLAN = 1, TUN_GRE = 2, TUN_GTPU = 3 };
+/* Flow key: v4 src|dst|proto|sport|dport (13B), v6 (37B); fragments and port-less protocols drop the ports (3-tuple). */
+typedef struct pkt_meta { uint16_t l2_len, l3_off, l4_off; uint8_t l3, proto, vlans, frag, tun, klen; uint8_t key[FKEY_MAX]; } pkt_meta;
+bool tunnel_hash_enabled(void);
+void parse_frame(const uint8_t *f, uint32_t len, pkt_meta *m, bool inner);
+void parse_burst(struct rte_mbuf **pkts, unsigned n, pkt_meta *meta, bool inner);
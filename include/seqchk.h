@@ -0,0 +1,21 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#pragma once
+#include "defs.h"
+#define SEQ_STAMP_OFF (WIRE_BYTES - 8)
+#define SEQ_HIST_BUCKETS 8u
+#define SEQ_WINDOW 64u
+/* Per-flow checker state (16B): stamped flow id, highest seq seen, 64-bit window of seqs below it. */
+typedef struct seq_state { uint32_t flow, max; uint64_t win; } seq_state;
+typedef struct seq_stats { uint64_t in_order, reordered, dup, gaps, late; uint64_t hist[SEQ_HIST_BUCKETS]; } seq_stats;
+extern volatile seq_stats g_seq; extern bool g_seq_on;
+bool seq_check_enabled(void); uint32_t seq_flows_from_env(void);
+void seq_init(uint32_t flows); void seq_fini(void);
+void seq_check_frame(const uint8_t *p, seq_stats *acc);
+void seq_check_burst(struct rte_mbuf **pkts, unsigned n);
+/* Stamp big-endian flow id + sequence into the last 8 payload bytes of a WIRE_BYTES frame. */
+static inline void seq_stamp(uint8_t *p, uint32_t flow, uint32_t seq){ uint8_t *s=p+SEQ_STAMP_OFF; s[0]=(uint8_t)(flow>>24); s[1]=(uint8_t)(flow>>16); s[2]=(uint8_t)(flow>>8); s[3]=(uint8_t)flow; s[4]=(uint8_t)(seq>>24); s[5]=(uint8_t)(seq>>16); s[6]=(uint8_t)(seq>>8); s[7]=(uint8_t)seq; }
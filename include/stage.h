@@ -0,0 +1,64 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#pragma once
+#include "defs.h"
+#include <rte_version.h>
+/* Zero-copy ring API: DPDK >= 20.11, experimental (build with -DALLOW_EXPERIMENTAL_API). */
+#if RTE_VERSION >= RTE_VERSION_NUM(20,11,0,0) && defined(ALLOW_EXPERIMENTAL_API)
+#define STAGE_HAVE_ZC 1
+#else
+#define STAGE_HAVE_ZC 0
+#endif
+#define STAGE_CAP 256u
+/* Default fill per ring kind: ingress and pipe are fed whole bursts, so a fill below BURST would split each one into two enqueues. */
+#define STAGE_DEFAULT_FILL_BURST BURST
+#define STAGE_DEFAULT_FILL_WORKER 64u
+#define STAGE_DEFAULT_TIMEOUT_US 20u
+#define STAGE_MAX_TIMEOUT_US 10000u
+enum ring_kind_e { RING_INGRESS = 0, RING_PIPE, RING_WORKER, RING_KIND_COUNT };
+/* Per-lcore ring call counters: enq/deq = calls that moved objects, objs = objects offered to enqueue. */
+typedef struct ring_ops { volatile uint64_t enq, deq, objs; } __rte_cache_aligned ring_ops;
+extern ring_ops g_ring_ops[RTE_MAX_LCORE];
+extern unsigned g_stage_fill[RING_KIND_COUNT]; extern uint64_t g_stage_timeout; extern uint32_t g_stage_timeout_us; extern bool g_ring_zc;
+/* Producer-side staging for one ring that survives across dequeues. With RING_ZC=on the first add reserves fill
+ * slots in the ring and objects are written straight into them; anything past a short reservation spills to obj[]. */
+typedef struct stage_buf { struct rte_ring *ring; ring_ops *ops; uint64_t since; uint32_t fill, cnt, room, n1, over; void **zc1, **zc2; void *obj[STAGE_CAP]; } stage_buf;
+/* A dequeued burst: copied into the caller's array, or (RING_ZC=on) read in place from the ring as two spans. */
+typedef struct ring_span { void **p1, **p2; unsigned n1, n; } ring_span;
+void stage_config_from_env(void);
+void stage_init(stage_buf *b, struct rte_ring *r, unsigned kind);
+void ring_ops_totals(uint64_t *ops, uint64_t *objs);
+static inline void stage_add(stage_buf *b, void *o, uint64_t now){
+	if(!b->cnt){ b->since=now;
+#if STAGE_HAVE_ZC
+		if(g_ring_zc){ struct rte_ring_zc_data z; b->room=rte_ring_enqueue_zc_burst_start(b->ring, b->fill, &z, NULL); b->zc1=(void**)z.ptr1; b->zc2=(void**)z.ptr2; b->n1=z.n1; b->over=0; }
+#endif
+	}
+#if STAGE_HAVE_ZC
+	if(g_ring_zc){ uint32_t i=b->cnt++; if(likely(i<b->room)){ if(likely(i<b->n1)) b->zc1[i]=o; else b->zc2[i-b->n1]=o; } else b->obj[b->over++]=o; return; }
+#endif
+	b->obj[b->cnt++]=o; }
+static inline bool stage_full(const stage_buf *b){ return b->cnt>=b->fill; }
+static inline bool stage_due(const stage_buf *b, uint64_t now){ return b->cnt && (b->cnt>=b->fill || now-b->since>=g_stage_timeout); }
+/* Publish everything staged; returns how many made it into the ring. Objects that spilled past a short zero-copy reservation get a
+ * second, copying enqueue; whatever still does not fit is left at (*left)[0..*nleft) for the caller to drop. */
+static inline unsigned stage_flush(stage_buf *b, void ***left, unsigned *nleft){ unsigned n=b->cnt; b->cnt=0; *nleft=0; if(!n) return 0; b->ops->enq++; b->ops->objs+=n;
+#if STAGE_HAVE_ZC
+	if(g_ring_zc){ unsigned sent=RTE_MIN(n, b->room); if(b->room) rte_ring_enqueue_zc_finish(b->ring, sent); unsigned more=0; if(unlikely(b->over)){ b->ops->enq++; more=rte_ring_enqueue_burst(b->ring, b->obj, b->over, NULL); } *left=b->obj+more; *nleft=b->over-more; return sent+more; }
+#endif
+	unsigned sent=rte_ring_enqueue_burst(b->ring, b->obj, n, NULL); *left=b->obj+sent; *nleft=n-sent; return sent; }
+static inline unsigned ring_take(struct rte_ring *r, void **buf, unsigned max, ring_span *s, ring_ops *ops){
+#if STAGE_HAVE_ZC
+	if(g_ring_zc){ struct rte_ring_zc_data z; unsigned n=rte_ring_dequeue_zc_burst_start(r, max, &z, NULL); s->p1=(void**)z.ptr1; s->p2=(void**)z.ptr2; s->n1=z.n1; s->n=n; if(n) ops->deq++; return n; }
+#endif
+	unsigned n=rte_ring_dequeue_burst(r, buf, max, NULL); s->p1=buf; s->p2=NULL; s->n1=n; s->n=n; if(n) ops->deq++; return n; }
+static inline void ring_done(struct rte_ring *r, const ring_span *s){
+#if STAGE_HAVE_ZC
+	if(g_ring_zc && s->n) rte_ring_dequeue_zc_finish(r, s->n);
+#endif
+	(void)r; (void)s; }
+static inline void* span_at(const ring_span *s, unsigned i){ return likely(i<s->n1)? s->p1[i] : s->p2[i-s->n1]; }
@@ -0,0 +1,76 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#include "bench.h"
+#include "globals.h"
+#include "parse.h"
+#include "hash.h"
+#include "core_distributor.h"
+#include "idle.h"
+#include "seqchk.h"
+#include "maglev.h"
+#include "egress.h"
+#include "stage.h"
+#include "core_generator.h"
+#define BENCH_FRAMES 256u
+#define BENCH_ITERS 4096u
+#define BENCH_FLEN 160u
+#define BENCH_BAL_FLOWS 65536u
+#define BENCH_IDLE_EVENTS 2000u
+#define BENCH_SEQ_PKTS (1u<<22)
+#define BENCH_SEQ_REORDER 64u
+#define BENCH_MG_FLOWS (1u<<20)
+#define BENCH_EG_ROUNDS 20000u
+#define BENCH_ST_RUN_MS 200u
+#define BENCH_ST_HIST 4096u
+enum fk_e { FK_IPV4, FK_VLAN, FK_QINQ, FK_IPV4_OPTS, FK_IPV4_FRAG, FK_IPV6, FK_IPV6_FRAG, FK_VXLAN, FK_GRE, FK_GTPU, FK_COUNT };
+static const char *const fk_name[FK_COUNT]={"ipv4","vlan","qinq","ipv4-opts","ipv4-frag","ipv6","ipv6-frag","vxlan","gre","gtpu"};
+static uint8_t g_bench_frames[BENCH_FRAMES][BENCH_FLEN] __rte_cache_aligned; static uint16_t g_bench_flen[BENCH_FRAMES]; static volatile uint32_t g_bench_sink;
+const char* bench_requested(void){ const char *s=getenv("BENCH"); return (s && s[0] && strcasecmp(s,"off")!=0)? s : NULL; }
+static inline void wr16(uint8_t *p, uint16_t v){ p[0]=(uint8_t)(v>>8); p[1]=(uint8_t)v; }
+static unsigned put_eth(uint8_t *p, uint16_t et){ memset(p,0,12); p[5]=0x01; p[11]=0x02; wr16(p+12,et); return 14; }
+static unsigned put_vlan(uint8_t *p, uint16_t tci, uint16_t et){ wr16(p,tci); wr16(p+2,et); return 4; }
+static unsigned put_ipv4(uint8_t *p, uint8_t proto, uint32_t v, unsigned opt_words, uint16_t frag){ unsigned ihl=5u+opt_words; memset(p,0,ihl*4u); p[0]=(uint8_t)(0x40u|ihl); wr16(p+6,frag); p[8]=64; p[9]=proto; p[12]=192; p[13]=168; p[14]=(uint8_t)(v>>8); p[15]=(uint8_t)v; p[16]=10; p[17]=0; p[18]=(uint8_t)(v>>16); p[19]=(uint8_t)(v>>3); return ihl*4u; }
+static unsigned put_ipv6(uint8_t *p, uint8_t nh, uint32_t v){ memset(p,0,40); p[0]=0x60; p[6]=nh; p[7]=64; p[8]=0x20; p[9]=0x01; p[22]=(uint8_t)(v>>8); p[23]=(uint8_t)v; p[24]=0x20; p[25]=0x01; p[38]=(uint8_t)(v>>16); p[39]=(uint8_t)(v>>3); return 40; }
+static unsigned put_l4(uint8_t *p, uint16_t sp, uint16_t dp, unsigned len){ memset(p,0,len); wr16(p,sp); wr16(p+2,dp); return len; }
+static unsigned put_inner_ip(uint8_t *p, uint32_t v){ unsigned o=put_ipv4(p,17,v,0,0); return o+put_l4(p+o,(uint16_t)(10000u+v),(uint16_t)(20000u+(v>>4)),8); }
+/* Synthetic frame of class `kind` for flow `v`; tunnel outers are a fixed VTEP/GTP peer pair so only the inner flow varies. */
+static unsigned build_frame(uint8_t *f, unsigned kind, uint32_t v){ unsigned o=0; const uint16_t sp=(uint16_t)(10000u+v), dp=(uint16_t)(20000u+v); switch(kind){ case FK_IPV4: o=put_eth(f,0x0800); o+=put_ipv4(f+o,17,v,0,0); o+=put_l4(f+o,sp,dp,8); break; case FK_VLAN: o=put_eth(f,0x8100); o+=put_vlan(f+o,100,0x0800); o+=put_ipv4(f+o,17,v,0,0); o+=put_l4(f+o,sp,dp,8); break; case FK_QINQ: o=put_eth(f,0x88A8); o+=put_vlan(f+o,200,0x8100); o+=put_vlan(f+o,100,0x0800); o+=put_ipv4(f+o,6,v,0,0); o+=put_l4(f+o,sp,dp,20); break; case FK_IPV4_OPTS: o=put_eth(f,0x0800); o+=put_ipv4(f+o,6,v,3,0); o+=put_l4(f+o,sp,dp,20); break; case FK_IPV4_FRAG: o=put_eth(f,0x0800); o+=put_ipv4(f+o,17,v,0,(v&1u)?0x2000u:0x00B9u); o+=put_l4(f+o,sp,dp,8); break; case FK_IPV6: o=put_eth(f,0x86DD); o+=put_ipv6(f+o,17,v); o+=put_l4(f+o,sp,dp,8); break; case FK_IPV6_FRAG: o=put_eth(f,0x86DD); o+=put_ipv6(f+o,44,v); memset(f+o,0,8); f[o]=17; wr16(f+o+2,(v&1u)?0x0001u:0x05C8u); o+=8; o+=put_l4(f+o,sp,dp,8); break; case FK_VXLAN: o=put_eth(f,0x0800); o+=put_ipv4(f+o,17,0,0,0); o+=put_l4(f+o,49152,4789,8); memset(f+o,0,8); f[o]=0x08; f[o+6]=0x2A; o+=8; o+=put_eth(f+o,0x0800); o+=put_inner_ip(f+o,v); break; case FK_GRE: o=put_eth(f,0x0800); o+=put_ipv4(f+o,47,0,0,0); wr16(f+o,0x2000); wr16(f+o+2,0x0800); memset(f+o+4,0,4); f[o+7]=0x2A; o+=8; o+=put_inner_ip(f+o,v); break; case FK_GTPU: o=put_eth(f,0x0800); o+=put_ipv4(f+o,17,0,0,0); o+=put_l4(f+o,2152,2152,8); memset(f+o,0,16); f[o]=0x34; f[o+1]=0xFF; f[o+7]=0x2A; f[o+11]=0x85; f[o+12]=1; f[o+13]=0x09; o+=16; o+=put_inner_ip(f+o,v); break; default: break; } return o<64u?64u:o; }
+static void parse_cost(unsigned kind, bool inner, double *cyc_parse, double *cyc_hash){ for(unsigned i=0;i<BENCH_FRAMES;i++) g_bench_flen[i]=(uint16_t)build_frame(g_bench_frames[i],kind,i+1u); pkt_meta m; uint32_t acc=0; uint64_t t0=rte_get_tsc_cycles(); for(unsigned it=0;it<BENCH_ITERS;it++){ for(unsigned i=0;i<BENCH_FRAMES;i++){ parse_frame(g_bench_frames[i],g_bench_flen[i],&m,inner); acc+=m.klen; } } uint64_t t1=rte_get_tsc_cycles(); for(unsigned it=0;it<BENCH_ITERS;it++){ for(unsigned i=0;i<BENCH_FRAMES;i++){ parse_frame(g_bench_frames[i],g_bench_flen[i],&m,inner); acc+=xxh32(m.key,m.klen,XXH32_SEED)^(uint32_t)xxh64(m.key,m.klen,XXH64_SEED); } } uint64_t t2=rte_get_tsc_cycles(); g_bench_sink=acc; const double pkts=(double)BENCH_ITERS*(double)BENCH_FRAMES; *cyc_parse=(double)(t1-t0)/pkts; *cyc_hash=(double)(t2-t1)/pkts; }
+static void balance(unsigned kind, bool inner, double *sd, double *peak){ unsigned cnt[16]={0}; uint8_t f[BENCH_FLEN]; pkt_meta m; for(uint32_t v=1;v<=BENCH_BAL_FLOWS;v++){ unsigned len=build_frame(f,kind,v); parse_frame(f,len,&m,inner); uint32_t h32=xxh32(m.key,m.klen,XXH32_SEED); cnt[pick_worker((h32>>24) & 0xFF)]++; } double mean=(double)BENCH_BAL_FLOWS/(double)NB_WORKERS, var=0.0, mx=0.0; for(unsigned wi=0; wi<NB_WORKERS; wi++){ double d=(double)cnt[wi]-mean; var+=d*d; if(cnt[wi]>mx) mx=(double)cnt[wi]; } *sd=sqrt(var/(double)NB_WORKERS); *peak=mx/mean; }
+void bench_parse(void){ const double hz=(double)rte_get_tsc_hz(); PERF_LOG("[bench] parse: %u frames x %u iters per class, tsc=%.0f MHz", BENCH_FRAMES, BENCH_ITERS, hz/1e6); for(unsigned k=0;k<FK_COUNT;k++){ for(unsigned in=0;in<2u;in++){ double cp, ch; parse_cost(k, in!=0u, &cp, &ch); PERF_LOG("[bench] parse class=%s inner=%s parse=%.1f cyc/pkt parse+hash=%.1f cyc/pkt (%.1f ns)", fk_name[k], in?"on":"off", cp, ch, hz>0? ch*1e9/hz:0.0); } } PERF_LOG("[bench] balance: %u inner flows over one tunnel endpoint pair, %u workers", BENCH_BAL_FLOWS, NB_WORKERS); const unsigned tun[3]={FK_VXLAN, FK_GRE, FK_GTPU}; for(unsigned t=0;t<3u;t++){ for(unsigned in=0;in<2u;in++){ double sd, peak; balance(tun[t], in!=0u, &sd, &peak); PERF_LOG("[bench] balance class=%s inner=%s flows stddev=%.1f max/mean=%.2f", fk_name[tun[t]], in?"on":"off", sd, peak); } } }
+static struct rte_ring *g_ib_ring; static volatile int g_ib_stop; static int g_ib_policy; static uint32_t g_ib_lat[BENCH_IDLE_EVENTS]; static unsigned g_ib_got; static uint64_t g_ib_busy, g_ib_idle, g_ib_deep;
+static int idle_bench_consumer(void *arg){ (void)arg; void *objs[BURST]; idle_state st; idle_init(&st, g_ib_policy); const uint64_t b0=st.acct->busy, i0=st.acct->idle, d0=st.acct->deep; while(!g_ib_stop){ unsigned n=rte_ring_dequeue_burst(g_ib_ring,objs,BURST,NULL); if(n==0){ idle_wait(&st, g_ib_ring); continue; } idle_resume(&st); uint64_t now=rte_get_tsc_cycles(); for(unsigned i=0;i<n;i++){ uint64_t d=now-(uint64_t)(uintptr_t)objs[i]; if(g_ib_got<BENCH_IDLE_EVENTS) g_ib_lat[g_ib_got++]=(uint32_t)RTE_MIN(d,(uint64_t)UINT32_MAX); } idle_account(&st); } idle_fini(&st); g_ib_busy=st.acct->busy-b0; g_ib_idle=st.acct->idle-i0; g_ib_deep=st.acct->deep-d0; return 0; }
+static int cmp_u32(const void *a, const void *b){ uint32_t x=*(const uint32_t*)a, y=*(const uint32_t*)b; return (x>y)-(x<y); }
+/* Package energy where the platform exposes RAPL; LX2160A has no such counter, so low-power residency is the portable proxy. */
+static long long read_energy_uj(void){ FILE *f=fopen("/sys/class/powercap/intel-rapl:0/energy_uj","r"); if(!f) return -1; long long v=-1; if(fscanf(f,"%lld",&v)!=1) v=-1; fclose(f); return v; }
+void bench_idle(void){ const unsigned lc=WORKERS[0]; if(!rte_lcore_is_enabled(lc)){ printf("[bench] idle: consumer lcore %u not enabled (-l)", lc); putchar('\n'); return; } idle_power_setup(); char name[64]; snprintf(name,sizeof(name),"RQ_BENCH_IDLE_%d", getpid()); g_ib_ring=rte_ring_create(name, 4096u, rte_socket_id(), RING_F_SP_ENQ|RING_F_SC_DEQ); if(!g_ib_ring) rte_exit(EXIT_FAILURE, "bench ring create failed: %s", rte_strerror(rte_errno)); const double us_per_cyc=1e6/(double)rte_get_tsc_hz(); PERF_LOG("[bench] idle: %u wake-ups, 20..1000 us random gaps, consumer lcore %u", BENCH_IDLE_EVENTS, lc); for(int p=0;p<IDLE_POLICY_COUNT;p++){ g_ib_policy=p; g_ib_stop=0; g_ib_got=0; rte_smp_wmb(); long long e0=read_energy_uj(); uint64_t t0=rte_get_tsc_cycles(); rte_eal_remote_launch(idle_bench_consumer, NULL, lc); uint32_t s=0xC0FFEE11u+(uint32_t)p; for(unsigned k=0;k<BENCH_IDLE_EVENTS;k++){ s=s*1664525u+1013904223u; rte_delay_us_block(20u+(s>>8)%981u); void *obj=(void*)(uintptr_t)rte_get_tsc_cycles(); while(rte_ring_enqueue_burst(g_ib_ring,&obj,1,NULL)==0) rte_pause(); } rte_delay_us_block(20000); g_ib_stop=1; rte_smp_wmb(); rte_eal_wait_lcore(lc); uint64_t t1=rte_get_tsc_cycles(); long long e1=read_energy_uj(); unsigned got=g_ib_got; qsort(g_ib_lat, got, sizeof(uint32_t), cmp_u32); double p50=got? g_ib_lat[got/2]*us_per_cyc:0, p99=got? g_ib_lat[(got*99u)/100u]*us_per_cyc:0, mx=got? g_ib_lat[got-1]*us_per_cyc:0; double tot=(double)(g_ib_busy+g_ib_idle); double util=tot>0? 100.0*(double)g_ib_busy/tot:0, lowp=tot>0? 100.0*(double)g_ib_deep/tot:0; char energy[32]; if(e0>=0 && e1>=e0) snprintf(energy,sizeof(energy),"%.3f W", (double)(e1-e0)/((double)(t1-t0)*us_per_cyc)); else snprintf(energy,sizeof(energy),"n/a"); PERF_LOG("[bench] idle policy=%s wake p50=%.2f us p99=%.2f us max=%.2f us util=%.1f%% low-power=%.1f%% power=%s", idle_policy_name(p), p50, p99, mx, util, lowp, energy); } }
+/* Random flow order over F flows; every BENCH_SEQ_REORDER-th packet of a flow is swapped with its successor, so reordered ~= pkts/64. */
+static uint64_t seq_stream(uint32_t flows, uint32_t *seqs, bool check, seq_stats *acc){ uint8_t f[WIRE_BYTES] __rte_cache_aligned; memset(f,0,sizeof(f)); memset(seqs,0,(size_t)flows*sizeof(uint32_t)); uint32_t s=0xC0FFEE11u; uint64_t t0=rte_get_tsc_cycles(); for(unsigned k=0;k<BENCH_SEQ_PKTS;k++){ s=s*1664525u+1013904223u; uint32_t flow=(s>>4) & (flows-1u); uint32_t q=++seqs[flow]; if((q % BENCH_SEQ_REORDER)==0u){ seq_stamp(f,flow,q+1u); if(check) seq_check_frame(f,acc); else acc->in_order+=f[WIRE_BYTES-1]; seq_stamp(f,flow,q); ++seqs[flow]; } else { seq_stamp(f,flow,q); } if(check) seq_check_frame(f,acc); else acc->in_order+=f[WIRE_BYTES-1]; } return rte_get_tsc_cycles()-t0; }
+void bench_seq(void){ static const uint32_t flows_set[4]={1024u, 65536u, 1u<<20, 1u<<22}; const double hz=(double)rte_get_tsc_hz(); PERF_LOG("[bench] seq: %u stamped packets per run, 1/%u packets of each flow reordered by one", BENCH_SEQ_PKTS, BENCH_SEQ_REORDER); for(unsigned r=0;r<4u;r++){ const uint32_t flows=flows_set[r]; uint32_t *seqs=(uint32_t*)malloc((size_t)flows*sizeof(uint32_t)); if(!seqs) rte_exit(EXIT_FAILURE, "bench seq alloc failed"); seq_init(flows); seq_stats base, acc; memset(&base,0,sizeof(base)); memset(&acc,0,sizeof(acc)); uint64_t tb=seq_stream(flows,seqs,false,&base); uint64_t tc=seq_stream(flows,seqs,true,&acc); g_bench_sink=(uint32_t)base.in_order; double cyc=(double)(tc>tb? tc-tb:0)/(double)BENCH_SEQ_PKTS; long long lost=(long long)acc.gaps-(long long)acc.late; PERF_LOG("[bench] seq flows=%u table=%.2f MB check=%.1f cyc/pkt (%.1f Mpps/core) in_order=%llu reordered=%llu dup=%llu lost=%lld dist1=%llu", flows, (double)flows*sizeof(seq_state)/1048576.0, cyc, cyc>0? hz/cyc/1e6:0.0, (unsigned long long)acc.in_order, (unsigned long long)acc.reordered, (unsigned long long)acc.dup, lost, (unsigned long long)acc.hist[0]); seq_fini(); free(seqs); } }
+/* RETA rebuilt the way build_reta() does it (contiguous runs per worker, fixed-seed shuffle), sized by weight. */
+static void reta_fill(uint8_t *t, const uint16_t *w){ uint64_t W=0; for(unsigned i=0;i<NB_WORKERS;i++) W+=w[i]; unsigned pos=0; for(unsigned i=0;i<NB_WORKERS && W;i++){ unsigned c=(unsigned)((uint64_t)RETA_SZ*w[i]/W); for(unsigned k=0;k<c && pos<RETA_SZ;k++) t[pos++]=(uint8_t)i; } for(unsigned i=0; pos<RETA_SZ; i=(i+1u)%NB_WORKERS){ if(w[i]) t[pos++]=(uint8_t)i; } uint32_t s=0xC0FFEE11u; for(int i=(int)RETA_SZ-1;i>0;--i){ s=s*1664525u+1013904223u; int j=(int)(s % (uint32_t)(i+1)); uint8_t x=t[i]; t[i]=t[j]; t[j]=x; } }
+static void map_flows(const uint32_t *h, uint8_t *out, const uint8_t *reta){ for(unsigned k=0;k<BENCH_MG_FLOWS;k++) out[k]= reta? reta[(h[k]>>24) & 0xFF] : (uint8_t)maglev_pick(h[k]); }
+static double remapped_pct(const uint8_t *a, const uint8_t *b){ unsigned d=0; for(unsigned k=0;k<BENCH_MG_FLOWS;k++) d+=(a[k]!=b[k]); return 100.0*(double)d/(double)BENCH_MG_FLOWS; }
+/* Worst per-worker deviation of the flow share from its weighted target, in percent. */
+static double share_dev_pct(const uint8_t *map, const uint16_t *w){ unsigned cnt[16]={0}; uint64_t W=0; for(unsigned i=0;i<NB_WORKERS;i++) W+=w[i]; for(unsigned k=0;k<BENCH_MG_FLOWS;k++) cnt[map[k]]++; double worst=0.0; for(unsigned i=0;i<NB_WORKERS;i++){ if(!w[i]) continue; double exp=(double)BENCH_MG_FLOWS*(double)w[i]/(double)W; double d=fabs((double)cnt[i]/exp-1.0)*100.0; if(d>worst) worst=d; } return worst; }
+static double min_move_pct(const uint16_t *a, const uint16_t *b){ double Wa=0, Wb=0, m=0; for(unsigned i=0;i<NB_WORKERS;i++){ Wa+=a[i]; Wb+=b[i]; } for(unsigned i=0;i<NB_WORKERS;i++){ double d=(double)a[i]/Wa-(double)b[i]/Wb; if(d>0) m+=d; } return 100.0*m; }
+void bench_maglev(void){ if(!g_fat) create_fat(); const double us_per_cyc=1e6/(double)rte_get_tsc_hz(); uint32_t *h=(uint32_t*)malloc(BENCH_MG_FLOWS*sizeof(uint32_t)); uint8_t *before=(uint8_t*)malloc(BENCH_MG_FLOWS), *inc=(uint8_t*)malloc(BENCH_MG_FLOWS), *full=(uint8_t*)malloc(BENCH_MG_FLOWS), *rb=(uint8_t*)malloc(BENCH_MG_FLOWS), *ra=(uint8_t*)malloc(BENCH_MG_FLOWS); if(!h || !before || !inc || !full || !rb || !ra) rte_exit(EXIT_FAILURE, "bench maglev alloc failed"); for(uint32_t k=0;k<BENCH_MG_FLOWS;k++) h[k]=xxh32(&k,sizeof(k),XXH32_SEED); uint16_t w[16]; for(unsigned i=0;i<NB_WORKERS;i++) w[i]=1; uint8_t reta[RETA_SZ]; reta_fill(reta,w); map_flows(h,rb,reta); PERF_LOG("[bench] maglev: %u sampled flows, %u workers", BENCH_MG_FLOWS, NB_WORKERS); PERF_LOG("[bench] maglev balance table=reta size=%u share_dev=%.2f%%", RETA_SZ, share_dev_pct(rb,w)); static const uint32_t sizes[3]={4096u, 65536u, 1u<<20}; for(unsigned r=0;r<3u;r++){ const uint32_t m=maglev_round_size(sizes[r]); uint64_t t0=rte_get_tsc_cycles(); maglev_init(m,w); uint64_t t1=rte_get_tsc_cycles(); map_flows(h,before,NULL); PERF_LOG("[bench] maglev balance table=maglev size=%u share_dev=%.2f%% build=%.1f us", m, share_dev_pct(before,w), (double)(t1-t0)*us_per_cyc); } maglev_init(MAGLEV_DEFAULT_SIZE, w); struct { const char *what; unsigned wi; uint16_t w; } ops[5]={{"remove",3,0},{"add",3,1},{"reweight",5,2},{"remove",7,0},{"add",7,1}}; for(unsigned o=0;o<5u;o++){ uint16_t wold[16]; memcpy(wold,w,sizeof(wold)); w[ops[o].wi]=ops[o].w; double minp=min_move_pct(wold,w); map_flows(h,before,NULL); uint64_t t0=rte_get_tsc_cycles(); unsigned moved=maglev_set_weight(ops[o].wi, ops[o].w); uint64_t t1=rte_get_tsc_cycles(); map_flows(h,inc,NULL); uint8_t *keep=(uint8_t*)malloc(g_maglev_size); if(!keep) rte_exit(EXIT_FAILURE, "bench maglev alloc failed"); memcpy(keep,g_maglev,g_maglev_size); uint64_t t2=rte_get_tsc_cycles(); maglev_build(w); uint64_t t3=rte_get_tsc_cycles(); map_flows(h,full,NULL); memcpy(g_maglev,keep,g_maglev_size); free(keep); uint8_t reta_old[RETA_SZ]; reta_fill(reta_old,wold); map_flows(h,rb,reta_old); reta_fill(reta,w); map_flows(h,ra,reta); PERF_LOG("[bench] maglev change=%s w%u->%u min=%.2f%% incremental: remapped=%.2f%% entries=%u rebuild=%.1f us share_dev=%.2f%% | full rebuild: remapped=%.2f%% %.1f us | reta rebuild: remapped=%.2f%% share_dev=%.2f%%", ops[o].what, ops[o].wi, ops[o].w, minp, remapped_pct(before,inc), moved, (double)(t1-t0)*us_per_cyc, share_dev_pct(inc,w), remapped_pct(before,full), (double)(t3-t2)*us_per_cyc, remapped_pct(rb,ra), share_dev_pct(ra,w)); } free(h); free(before); free(inc); free(full); free(rb); free(ra); }
+void bench_egress(void){ if(!g_mpool) create_mempools(); struct rte_mbuf *pkts[SINK_BURST]; const unsigned sizes[3]={32u, 128u, SINK_BURST}; PERF_LOG("[bench] egress: mbuf release cost, %u rounds per burst size", BENCH_EG_ROUNDS); for(unsigned r=0;r<3u;r++){ const unsigned n=sizes[r]; uint64_t c_one=0, c_bulk=0; for(unsigned it=0; it<BENCH_EG_ROUNDS; it++){ if(rte_pktmbuf_alloc_bulk(g_mpool,pkts,n)!=0) rte_exit(EXIT_FAILURE, "bench egress alloc failed"); uint64_t t0=rte_get_tsc_cycles(); for(unsigned i=0;i<n;i++) rte_pktmbuf_free(pkts[i]); uint64_t t1=rte_get_tsc_cycles(); c_one+=t1-t0; if(rte_pktmbuf_alloc_bulk(g_mpool,pkts,n)!=0) rte_exit(EXIT_FAILURE, "bench egress alloc failed"); t0=rte_get_tsc_cycles(); egress_free_bulk(pkts,n); c_bulk+=rte_get_tsc_cycles()-t0; } const double pk=(double)BENCH_EG_ROUNDS*(double)n; PERF_LOG("[bench] egress burst=%u per-packet free=%.1f cyc/pkt bulk free=%.1f cyc/pkt", n, (double)c_one/pk, (double)c_bulk/pk); } }
+static struct rte_ring *g_sb_rings[NB_WORKERS]; static unsigned g_sb_nq=NB_WORKERS; static volatile int g_sb_stop; static uint64_t g_sb_got, g_sb_lat_sum, g_sb_lat_max; static uint32_t g_sb_hist[BENCH_ST_HIST];
+/* Drains the g_sb_nq rings in use like Dist-A or a set of workers would; objects are TSC stamps taken when the producer staged them. */
+static int stage_bench_consumer(void *arg){ (void)arg; void *objs[BURST]; ring_ops *ops=&g_ring_ops[rte_lcore_id()]; ring_span sp; const uint64_t tenth_us=RTE_MAX(rte_get_tsc_hz()/10000000ull, 1ull); for(int last=0; !last;){ last=g_sb_stop; for(unsigned q=0;q<g_sb_nq;q++){ unsigned n=ring_take(g_sb_rings[q],objs,BURST,&sp,ops); if(!n) continue; uint64_t now=rte_get_tsc_cycles(); for(unsigned i=0;i<n;i++){ uint64_t d=now-(uint64_t)(uintptr_t)span_at(&sp,i); g_sb_lat_sum+=d; if(d>g_sb_lat_max) g_sb_lat_max=d; g_sb_hist[RTE_MIN(d/tenth_us, (uint64_t)BENCH_ST_HIST-1u)]++; } ring_done(g_sb_rings[q],&sp); g_sb_got+=n; } } return 0; }
+/* Producer for one ring kind: bursts of BURST objects into one ring (generator, Dist-A) or spread over the worker rings at random
+ * (Dist-B), paced at pps (0 = as fast as possible). */
+static uint64_t stage_bench_run(unsigned lc, double pps, unsigned kind, uint64_t *drops){ g_sb_nq=(kind==RING_WORKER)? NB_WORKERS : 1u; g_sb_stop=0; g_sb_got=0; g_sb_lat_sum=0; g_sb_lat_max=0; memset(g_sb_hist,0,sizeof(g_sb_hist)); rte_smp_wmb(); rte_eal_remote_launch(stage_bench_consumer, NULL, lc); stage_buf wk[NB_WORKERS]; for(unsigned q=0;q<g_sb_nq;q++) stage_init(&wk[q], g_sb_rings[q], kind); const uint64_t hz=rte_get_tsc_hz(); const uint64_t gap=pps>0.0? (uint64_t)((double)hz*(double)BURST/pps) : 0u; uint64_t now=rte_get_tsc_cycles(), next=now, t0=now; const uint64_t end=now+hz*BENCH_ST_RUN_MS/1000u; uint32_t s=0xC0FFEE11u; *drops=0; void **left; unsigned nl; while((now=rte_get_tsc_cycles())<end){ if(now>=next){ next+=gap; for(unsigned k=0;k<BURST;k++){ s=s*1664525u+1013904223u; unsigned q=(s>>8)%g_sb_nq; stage_add(&wk[q], (void*)(uintptr_t)now, now); if(stage_full(&wk[q])){ stage_flush(&wk[q],&left,&nl); *drops+=nl; } } } for(unsigned q=0;q<g_sb_nq;q++){ if(stage_due(&wk[q],now)){ stage_flush(&wk[q],&left,&nl); *drops+=nl; } } } for(unsigned q=0;q<g_sb_nq;q++){ stage_flush(&wk[q],&left,&nl); *drops+=nl; } rte_delay_us_block(1000); g_sb_stop=1; rte_smp_wmb(); rte_eal_wait_lcore(lc); return rte_get_tsc_cycles()-t0; }
+static double hist_pct_us(double pct){ uint64_t tot=0, acc=0; for(unsigned b=0;b<BENCH_ST_HIST;b++) tot+=g_sb_hist[b]; const uint64_t want=(uint64_t)((double)tot*pct/100.0); for(unsigned b=0;b<BENCH_ST_HIST;b++){ acc+=g_sb_hist[b]; if(acc>=want && acc) return (double)(b+1u)/10.0; } return 0.0; }
+static const char *const g_sb_kind[RING_KIND_COUNT]={"ingress","pipe","worker"};
+/* One row: a paced run for ring calls, batch size and latency, then an unpaced run for max Mpps. */
+static void stage_bench_row(unsigned lc, double pps, unsigned kind, const char *run, unsigned fill, uint32_t tmo_us){ const double hz=(double)rte_get_tsc_hz(), us_per_cyc=1e6/hz; const ring_ops *po=&g_ring_ops[rte_lcore_id()], *co=&g_ring_ops[lc]; g_stage_fill[kind]=fill; g_stage_timeout_us=tmo_us; g_stage_timeout=(uint64_t)tmo_us*rte_get_tsc_hz()/1000000ull; uint64_t e0=po->enq, b0=po->objs, d0=co->deq, drops=0; stage_bench_run(lc, pps, kind, &drops); uint64_t enq=po->enq-e0, objs=po->objs-b0, deq=co->deq-d0, got=g_sb_got; double avg=got? (double)g_sb_lat_sum/(double)got*us_per_cyc : 0.0, mx=(double)g_sb_lat_max*us_per_cyc, p99=hist_pct_us(99.0); uint64_t fdrops=0; uint64_t cyc=stage_bench_run(lc, 0.0, kind, &fdrops); double mpps=(double)g_sb_got/((double)cyc/hz)/1e6; PERF_LOG("[bench] stage %-7s %-6s %4u %10u | %7.3f (%.3f + %.3f) | %6.1f | %7.2f / %7.1f / %7.1f | %6.2f%s", g_sb_kind[kind], run, fill, tmo_us, objs? (double)(enq+deq)/(double)objs : 0.0, objs? (double)enq/(double)objs : 0.0, objs? (double)deq/(double)objs : 0.0, enq? (double)objs/(double)enq : 0.0, avg, p99, mx, mpps, drops? " (paced drops)" : ""); }
+/* Per ring kind: "before" is the unstaged pipeline (one enqueue per burst per ring: fill=STAGE_CAP, timeout 0), "after" the configured
+ * fill; worker rings also sweep the timeout. */
+void bench_stage(void){ const unsigned lc=WORKERS[0]; if(!rte_lcore_is_enabled(lc)){ printf("[bench] stage: consumer lcore %u not enabled (-l)", lc); putchar('\n'); return; } char name[64]; for(unsigned q=0;q<NB_WORKERS;q++){ snprintf(name,sizeof(name),"RQ_BENCH_STAGE_%u_%d", q, getpid()); g_sb_rings[q]=rte_ring_create(name, RING_SIZE, rte_socket_id(), RING_F_SP_ENQ|RING_F_SC_DEQ); if(!g_sb_rings[q]) rte_exit(EXIT_FAILURE, "bench ring create failed: %s", rte_strerror(rte_errno)); } static const uint32_t tmo[6]={5u, 10u, 20u, 50u, 100u, 200u}; const double pps=get_target_pps_from_env(); const uint32_t keep_us=g_stage_timeout_us; const uint64_t keep=g_stage_timeout; unsigned keep_fill[RING_KIND_COUNT]; memcpy(keep_fill, g_stage_fill, sizeof(keep_fill)); PERF_LOG("[bench] stage: 1 producer -> ingress/pipe (1 ring) or worker (%u rings) -> consumer lcore %u, %u ms per run, paced at %.2f Mpps, burst=%u zc=%s", NB_WORKERS, lc, BENCH_ST_RUN_MS, pps/1e6, BURST, g_ring_zc?"on":"off"); PERF_LOG("[bench] stage ring    run    fill timeout_us | ring ops/pkt (enq+deq) | avg enq batch | added latency avg / p99 / max (us) | max Mpps"); for(unsigned k=0;k<RING_KIND_COUNT;k++){ stage_bench_row(lc, pps, k, "before", STAGE_CAP, 0u); if(k!=RING_WORKER){ stage_bench_row(lc, pps, k, "after", keep_fill[k], keep_us); continue; } for(unsigned r=0;r<6u;r++) stage_bench_row(lc, pps, k, "after", keep_fill[k], tmo[r]); } memcpy(g_stage_fill, keep_fill, sizeof(keep_fill)); g_stage_timeout_us=keep_us; g_stage_timeout=keep; for(unsigned q=0;q<NB_WORKERS;q++) rte_ring_free(g_sb_rings[q]); }
+int run_bench(const char *name){ if(strcasecmp(name,"parse")==0){ bench_parse(); return 0; } if(strcasecmp(name,"idle")==0){ bench_idle(); return 0; } if(strcasecmp(name,"seq")==0){ bench_seq(); return 0; } if(strcasecmp(name,"maglev")==0){ bench_maglev(); return 0; } if(strcasecmp(name,"egress")==0){ bench_egress(); return 0; } if(strcasecmp(name,"stage")==0){ bench_stage(); return 0; } printf("[bench] unknown benchmark: %s", name); putchar('\n'); return -1; }
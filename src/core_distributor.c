@@ -8,10 +8,18 @@
 #include "globals.h"
 #include "hash.h"
 #include "fat.h"
+#include "parse.h"
+#include "idle.h"
+#include "maglev.h"
+#include "stage.h"
 #define FLOW_SET_SIZE 4096u
 static uint32_t g_flow_set[16][FLOW_SET_SIZE] __rte_cache_aligned; static uint32_t g_flow_seen_epoch[16][FLOW_SET_SIZE] __rte_cache_aligned;
 void track_flow(unsigned wi,uint32_t sig){ const uint32_t mask=FLOW_SET_SIZE-1u; uint32_t idx=sig & mask; for(unsigned probe=0; probe<8u; ++probe){ if (g_flow_seen_epoch[wi][idx] != g_epoch){ g_flow_seen_epoch[wi][idx]=g_epoch; g_flow_set[wi][idx]=sig; g_flow_count[wi]++; return; } if (g_flow_set[wi][idx]==sig){ return; } idx=(idx+1u)&mask; } }
 uint16_t pick_worker(uint32_t h){ return (uint16_t)g_reta[h & RETA_MASK]; }
 struct dist_item { struct rte_mbuf *m; uint16_t wi; uint32_t flow_sig; };
-int distA_main(void *arg){ (void)arg; puts("[Distributor-A] started (FAT: 8B, 56+3+5; XXH32/XXH64)"); struct rte_mbuf *rx[BURST]; struct dist_item *items[BURST]; while(!g_quit){ unsigned n=rte_ring_dequeue_burst(g_ingress_ring,(void**)rx,BURST,NULL); if(unlikely(n==0)){ rte_pause(); continue;} g_dist_rx+=n; unsigned w=0; for(unsigned i=0;i<n;i++){ if(likely(i+1<n)){ rte_prefetch0(rte_pktmbuf_mtod(rx[i+1], void*)); } rte_prefetch0(rte_pktmbuf_mtod(rx[i], void*)); struct dist_item *di=NULL; if(unlikely(rte_mempool_get(g_pipe_pool,(void**)&di)!=0 || di==NULL)){ rte_pktmbuf_free(rx[i]); g_dist_drop++; items[i]=NULL; continue; } const uint8_t *p=rte_pktmbuf_mtod(rx[i], const uint8_t*); const uint8_t *ip=p+14; const uint8_t *l4=ip+20; uint8_t tuple13[13]; memcpy(tuple13, ip+12,4); memcpy(tuple13+4, ip+16,4); tuple13[8]=ip[9]; tuple13[9]=l4[0]; tuple13[10]=l4[1]; tuple13[11]=l4[2]; tuple13[12]=l4[3]; uint64_t h64=xxh64(tuple13,sizeof(tuple13),XXH64_SEED); uint32_t h32=xxh32(tuple13,sizeof(tuple13),XXH32_SEED); uint64_t fp56=h64>>8; uint16_t wi; if(fat_lookup_tag(fp56,h64,&wi)){ g_fat_hits++; } else { uint32_t reta_idx=(h32>>24) & 0xFF; wi=pick_worker(reta_idx); fat_insert_tag(fp56,h64,wi); g_fat_misses++; } di->m=rx[i]; di->wi=wi; di->flow_sig=h32; items[w++]=di; } if(w){ unsigned pushed=rte_ring_enqueue_burst(g_dist_pipe,(void**)items,w,NULL); if(unlikely(pushed<w)){ for(unsigned i=pushed;i<w;i++){ if(items[i]){ rte_pktmbuf_free(items[i]->m); rte_mempool_put(g_pipe_pool, items[i]); g_dist_drop++; } } } } } return 0; }
-int distB_main(void *arg){ (void)arg; puts("[Distributor-B] started"); struct dist_item *items[BURST]; struct rte_mbuf *wk_pkts[16][BURST]; uint16_t wk_cnt[16]; while(!g_quit){ unsigned n=rte_ring_dequeue_burst(g_dist_pipe,(void**)items,BURST,NULL); if(unlikely(n==0)){ rte_pause(); continue;} for(unsigned wi=0; wi<NB_WORKERS; wi++){ wk_cnt[wi]=0; } for(unsigned i=0;i<n;i++){ rte_prefetch0(items[i]); if(likely(i+1<n)) rte_prefetch0(items[i+1]); } for(unsigned i=0;i<n;i++){ struct dist_item *di=items[i]; if(unlikely(!di)) continue; unsigned wi=di->wi; struct rte_mbuf *m=di->m; uint32_t sig=di->flow_sig; if(unlikely(wi>=NB_WORKERS)){ rte_pktmbuf_free(m); rte_mempool_put(g_pipe_pool,di); g_dist_drop++; continue; } unsigned pos=wk_cnt[wi]; if(pos<BURST){ wk_pkts[wi][pos]=m; wk_cnt[wi]=(uint16_t)(pos+1); track_flow(wi,sig);} else { unsigned sent=rte_ring_enqueue_burst(g_worker_rings[wi],(void**)wk_pkts[wi],pos,NULL); g_dist_tx+=sent; for(unsigned j=sent;j<pos;j++){ rte_pktmbuf_free(wk_pkts[wi][j]); g_worker_drop[wi]++; g_dist_drop++; } wk_cnt[wi]=0; wk_pkts[wi][wk_cnt[wi]++]=m; } rte_mempool_put(g_pipe_pool, di);} for(unsigned wi=0; wi<NB_WORKERS; wi++){ unsigned cnt=wk_cnt[wi]; if(!cnt) continue; unsigned sent=rte_ring_enqueue_burst(g_worker_rings[wi],(void**)wk_pkts[wi],cnt,NULL); g_dist_tx+=sent; for(unsigned j=sent;j<cnt;j++){ rte_pktmbuf_free(wk_pkts[wi][j]); g_worker_drop[wi]++; g_dist_drop++; } wk_cnt[wi]=0; } } return 0; }
+static inline void distA_flush(stage_buf *b){ void **left; unsigned nl; stage_flush(b,&left,&nl); for(unsigned i=0;i<nl;i++){ struct dist_item *di=(struct dist_item*)left[i]; rte_pktmbuf_free(di->m); rte_mempool_put(g_pipe_pool, di); g_dist_drop++; } }
+int distA_main(void *arg){ (void)arg; const bool inner=tunnel_hash_enabled(); printf("[Distributor-A] started (FAT: 8B, 56+3+5; XXH32/XXH64; tunnel-hash=%s)", inner?"on":"off"); putchar('\n'); struct rte_mbuf *rx[BURST]; pkt_meta meta[BURST]; const bool mg=g_maglev_on; stage_buf pipe; stage_init(&pipe, g_dist_pipe, RING_PIPE); ring_ops *ops=&g_ring_ops[rte_lcore_id()]; ring_span sp; idle_state st; idle_init(&st, idle_policy_from_env()); while(!g_quit){ unsigned n=ring_take(g_ingress_ring,(void**)rx,BURST,&sp,ops); if(unlikely(n==0)){ if(pipe.cnt) distA_flush(&pipe); idle_wait(&st, g_ingress_ring); continue;} idle_resume(&st); g_dist_rx+=n; const uint64_t now=rte_get_tsc_cycles(); parse_burst((struct rte_mbuf**)sp.p1,sp.n1,meta,inner); if(unlikely(n>sp.n1)) parse_burst((struct rte_mbuf**)sp.p2,n-sp.n1,meta+sp.n1,inner); for(unsigned i=0;i<n;i++){ struct rte_mbuf *m=(struct rte_mbuf*)span_at(&sp,i); struct dist_item *di=NULL; if(unlikely(rte_mempool_get(g_pipe_pool,(void**)&di)!=0 || di==NULL)){ rte_pktmbuf_free(m); g_dist_drop++; continue; } const pkt_meta *pm=&meta[i]; uint64_t h64=xxh64(pm->key,pm->klen,XXH64_SEED); uint32_t h32=xxh32(pm->key,pm->klen,XXH32_SEED); uint64_t fp56=h64>>8; uint16_t wi; if(fat_lookup_tag(fp56,h64,&wi)){ g_fat_hits++; } else { if(mg){ wi=maglev_pick(h32); } else { uint32_t reta_idx=(h32>>24) & 0xFF; wi=pick_worker(reta_idx); } fat_insert_tag(fp56,h64,wi); g_fat_misses++; } di->m=m; di->wi=wi; di->flow_sig=h32; stage_add(&pipe, di, now); if(stage_full(&pipe)) distA_flush(&pipe); } ring_done(g_ingress_ring,&sp); if(stage_due(&pipe, now)) distA_flush(&pipe); idle_account(&st); } distA_flush(&pipe); idle_fini(&st); return 0; }
+static inline void distB_flush(stage_buf *b, unsigned wi){ void **left; unsigned nl; g_dist_tx+=stage_flush(b,&left,&nl); if(unlikely(nl)){ for(unsigned j=0;j<nl;j++) rte_pktmbuf_free((struct rte_mbuf*)left[j]); g_worker_drop[wi]+=nl; g_dist_drop+=nl; } }
+/* Per-worker batches persist across dequeues: a worker ring sees one enqueue per STAGE_FILL packets, or per STAGE_TIMEOUT_US when
+ * its share of traffic is light; nothing is held once the pipe runs dry. */
+int distB_main(void *arg){ (void)arg; puts("[Distributor-B] started"); struct dist_item *items[BURST]; stage_buf wk[NB_WORKERS]; for(unsigned wi=0; wi<NB_WORKERS; wi++) stage_init(&wk[wi], g_worker_rings[wi], RING_WORKER); ring_ops *ops=&g_ring_ops[rte_lcore_id()]; ring_span sp; idle_state st; idle_init(&st, idle_policy_from_env()); while(!g_quit){ unsigned n=ring_take(g_dist_pipe,(void**)items,BURST,&sp,ops); if(unlikely(n==0)){ for(unsigned wi=0; wi<NB_WORKERS; wi++){ if(wk[wi].cnt) distB_flush(&wk[wi],wi); } idle_wait(&st, g_dist_pipe); continue;} idle_resume(&st); const uint64_t now=rte_get_tsc_cycles(); for(unsigned i=0;i<n;i++){ rte_prefetch0(span_at(&sp,i)); } for(unsigned i=0;i<n;i++){ struct dist_item *di=(struct dist_item*)span_at(&sp,i); if(unlikely(!di)) continue; unsigned wi=di->wi; struct rte_mbuf *m=di->m; uint32_t sig=di->flow_sig; if(unlikely(wi>=NB_WORKERS)){ rte_pktmbuf_free(m); rte_mempool_put(g_pipe_pool,di); g_dist_drop++; continue; } stage_add(&wk[wi], m, now); track_flow(wi,sig); if(stage_full(&wk[wi])) distB_flush(&wk[wi],wi); rte_mempool_put(g_pipe_pool, di);} ring_done(g_dist_pipe,&sp); for(unsigned wi=0; wi<NB_WORKERS; wi++){ if(stage_due(&wk[wi],now)) distB_flush(&wk[wi],wi); } idle_account(&st); } for(unsigned wi=0; wi<NB_WORKERS; wi++) distB_flush(&wk[wi],wi); idle_fini(&st); return 0; }
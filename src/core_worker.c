@@ -6,5 +6,11 @@
  */
 #include "core_worker.h"
 #include "globals.h"
-int worker_main(void *arg){ unsigned idx=(unsigned)(uintptr_t)arg; unsigned lcore=WORKERS[idx]; printf("[worker-%u] started", lcore); putchar('\n'); struct rte_ring *in=g_worker_rings[idx]; struct rte_ring *out=g_tx_rings[idx]; struct rte_mbuf *pkts[BURST]; while(!g_quit){ unsigned n=rte_ring_dequeue_burst(in,(void**)pkts,BURST,NULL); if(unlikely(n==0)){ rte_pause(); continue;} g_worker_rx[idx]+=n; unsigned sent=rte_ring_enqueue_burst(out,(void**)pkts,n,NULL); g_worker_tx[idx]+=sent; for(unsigned i=sent;i<n;i++){ rte_pktmbuf_free(pkts[i]); g_worker_drop[idx]++; } } return 0; }
-int sink_main(void *arg){ (void)arg; puts("[sink] started"); struct rte_mbuf *pkts[256]; while(!g_quit){ for(unsigned q=0;q<NB_WORKERS;q++){ unsigned n=rte_ring_dequeue_burst(g_tx_rings[q],(void**)pkts,256,NULL); for(unsigned i=0;i<n;i++){ rte_pktmbuf_free(pkts[i]); } } rte_pause(); } return 0; }
+#include "idle.h"
+#include "seqchk.h"
+#include "egress.h"
+#include "stage.h"
+#include "health.h"
+static inline void span_free(const ring_span *s, unsigned from){ if(from<s->n1){ egress_free_bulk((struct rte_mbuf**)s->p1+from, s->n1-from); from=s->n1; } if(from<s->n) egress_free_bulk((struct rte_mbuf**)s->p2+(from-s->n1), s->n-from); }
+int worker_main(void *arg){ unsigned idx=(unsigned)(uintptr_t)arg; unsigned lcore=WORKERS[idx]; printf("[worker-%u] started", lcore); putchar('\n'); struct rte_ring *in=g_worker_rings[idx]; struct rte_ring *out=g_tx_rings[idx]; struct rte_mbuf *pkts[BURST]; const bool direct=(g_egress_mode==EGRESS_DIRECT); ring_ops *ops=&g_ring_ops[rte_lcore_id()]; ring_span sp; idle_state st; idle_init(&st, idle_policy_from_env()); while(!g_quit){ worker_heartbeat(idx); unsigned n=ring_take(in,(void**)pkts,BURST,&sp,ops); if(unlikely(n==0)){ idle_wait(&st, in); continue;} idle_resume(&st); g_worker_rx[idx]+=n; if(direct){ span_free(&sp,0); ring_done(in,&sp); g_worker_tx[idx]+=n; idle_account(&st); continue; } unsigned sent=rte_ring_enqueue_burst(out,sp.p1,sp.n1,NULL); if(unlikely(n>sp.n1) && sent==sp.n1) sent+=rte_ring_enqueue_burst(out,sp.p2,n-sp.n1,NULL); g_worker_tx[idx]+=sent; if(unlikely(sent<n)){ span_free(&sp,sent); g_worker_drop[idx]+=n-sent; } ring_done(in,&sp); idle_account(&st); } idle_fini(&st); return 0; }
+int sink_main(void *arg){ unsigned shard=(unsigned)(uintptr_t)arg; printf("[sink] started (shard %u/%u)", shard, g_nb_sinks); putchar('\n'); struct rte_mbuf *pkts[SINK_BURST]; const bool seq_on=g_seq_on; idle_state st; idle_init(&st, idle_policy_from_env()); while(!g_quit){ unsigned total=0; for(unsigned q=shard;q<NB_WORKERS;q+=g_nb_sinks){ unsigned n=rte_ring_dequeue_burst(g_tx_rings[q],(void**)pkts,SINK_BURST,NULL); if(!n) continue; if(seq_on) seq_check_burst(pkts,n); egress_free_bulk(pkts,n); total+=n; } if(total==0){ idle_wait(&st, NULL); continue; } g_sink_rx[shard]+=total; idle_resume(&st); idle_account(&st); } idle_fini(&st); return 0; }
@@ -0,0 +1,32 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#include "egress.h"
+#include "globals.h"
+#include <rte_version.h>
+int g_egress_mode=EGRESS_SINK; unsigned g_nb_sinks=1u, g_sink_cores[MAX_SINKS]={3u};
+volatile uint64_t g_sink_rx[MAX_SINKS]={0};
+const char* egress_mode_name(void){ return g_egress_mode==EGRESS_DIRECT? "direct" : "sink"; }
+static unsigned main_lcore(void){
+#if RTE_VERSION >= RTE_VERSION_NUM(20,11,0,0)
+	return rte_get_main_lcore();
+#else
+	return rte_get_master_lcore();
+#endif
+}
+/* A sink lcore must not be the main lcore, another role's lcore or another sink: rte_eal_remote_launch() would fail with -EBUSY. */
+static void check_sink_core(unsigned lc, unsigned k){ const char *clash=NULL; if(lc>=RTE_MAX_LCORE) clash="out of range"; else if(lc==main_lcore()) clash="the main lcore"; else if(lc==PERF_CORE) clash="the perf core"; else if(lc==GEN_CORE) clash="the generator core"; else if(lc==DISTA_CORE) clash="the Distributor-A core"; else if(lc==DISTB_CORE) clash="the Distributor-B core"; for(unsigned i=0;!clash && i<NB_WORKERS;i++) if(lc==WORKERS[i]) clash="a worker core"; for(unsigned j=0;!clash && j<k;j++) if(lc==g_sink_cores[j]) clash="listed twice"; if(clash) rte_exit(EXIT_FAILURE, "SINK_CORES: lcore %u is %s", lc, clash); }
+/* EGRESS=sink|direct; SINK_CORES=<lcore>[,<lcore>...] shards the TX rings over up to MAX_SINKS sinks (worker wi -> shard wi % n). */
+void egress_config_from_env(void){ const char *m=getenv("EGRESS"); g_egress_mode=(m && strcasecmp(m,"direct")==0)? EGRESS_DIRECT : EGRESS_SINK; g_nb_sinks=1u; g_sink_cores[0]=SINK_CORE; const char *s=getenv("SINK_CORES"); if(!s || !s[0]) return; unsigned n=0; while(*s && n<MAX_SINKS){ char *end=NULL; unsigned long v=strtoul(s,&end,10); if(end==s) break; g_sink_cores[n++]=(unsigned)v; s=end; if(*s==',') s++; } if(n) g_nb_sinks=RTE_MIN(n, NB_WORKERS); for(unsigned k=0;g_egress_mode==EGRESS_SINK && k<g_nb_sinks;k++) check_sink_core(g_sink_cores[k], k); }
+/* Bulk release. DPDK >= 20.02 has rte_pktmbuf_free_bulk(); on 19.11 do the same by hand: prefree each
+ * single-segment mbuf and return runs from one pool with a single rte_mempool_put_bulk(). */
+void egress_free_bulk(struct rte_mbuf **pkts, unsigned n){
+#if RTE_VERSION >= RTE_VERSION_NUM(20,2,0,0)
+	rte_pktmbuf_free_bulk(pkts, n);
+#else
+	void *batch[SINK_BURST]; struct rte_mempool *mp=NULL; unsigned k=0; for(unsigned i=0;i<n;i++){ struct rte_mbuf *m=pkts[i]; if(unlikely(m->nb_segs!=1)){ rte_pktmbuf_free(m); continue; } m=rte_pktmbuf_prefree_seg(m); if(unlikely(!m)) continue; if(k && (m->pool!=mp || k==SINK_BURST)){ rte_mempool_put_bulk(mp, batch, k); k=0; } mp=m->pool; batch[k++]=m; } if(k) rte_mempool_put_bulk(mp, batch, k);
+#endif
+}
@@ -7,6 +7,11 @@
 #include "globals.h"
 #include "flow.h"
 #include "fat.h"
+#include "idle.h"
+#include "maglev.h"
+#include "egress.h"
+#include "stage.h"
+#include "health.h"
 const unsigned PERF_CORE=5, DISTA_CORE=6, DISTB_CORE=7, GEN_CORE=4, SINK_CORE=3;
 const unsigned WORKERS[NB_WORKERS] = {8,9,10,11,12,13,14,15};
 volatile sig_atomic_t g_quit = 0;
@@ -24,5 +29,5 @@ void create_mempools(void){ unsigned nb_mbufs=8192u + NB_WORKERS*4096u; g_mpool=
 void create_rings(void){ char rpfx[16]; snprintf(rpfx,sizeof(rpfx), "%d", getpid()); char name[64]; snprintf(name,sizeof(name), "RQ_INGRESS_%s", rpfx); g_ingress_ring=rte_ring_create(name, RING_SIZE, rte_socket_id(), RING_F_SP_ENQ|RING_F_SC_DEQ); if(!g_ingress_ring) rte_exit(EXIT_FAILURE, "ingress ring create failed: %s", rte_strerror(rte_errno)); snprintf(name,sizeof(name), "RQ_DIST_PIPE_%s", rpfx); g_dist_pipe=rte_ring_create(name, PIPE_SIZE, rte_socket_id(), RING_F_SP_ENQ|RING_F_SC_DEQ); if(!g_dist_pipe) rte_exit(EXIT_FAILURE, "dist pipe create failed: %s", rte_strerror(rte_errno)); for(unsigned i=0;i<NB_WORKERS;i++){ snprintf(name,sizeof(name), "RQ_WR_%u_%s", WORKERS[i], rpfx); g_worker_rings[i]=rte_ring_create(name, RING_SIZE, rte_socket_id(), RING_F_SP_ENQ|RING_F_SC_DEQ); if(!g_worker_rings[i]) rte_exit(EXIT_FAILURE, "worker ring create failed: %s", rte_strerror(rte_errno)); snprintf(name,sizeof(name), "RQ_TX_%u_%s", WORKERS[i], rpfx); g_tx_rings[i]=rte_ring_create(name, RING_SIZE, rte_socket_id(), RING_F_SP_ENQ|RING_F_SC_DEQ); if(!g_tx_rings[i]) rte_exit(EXIT_FAILURE, "tx ring create failed: %s", rte_strerror(rte_errno)); } }
 void build_reta(void){ for(unsigned i=0,w=0,c=0;i<RETA_SZ;i++){ g_reta[i]=w; if(++c==32u){c=0; if(++w==NB_WORKERS) w=0;} } uint32_t s=0xC0FFEE11u; for(int i=(int)RETA_SZ-1;i>0;--i){ int j=(int)(lcg32_local(&s) % (uint32_t)(i+1)); uint8_t t=g_reta[i]; g_reta[i]=g_reta[j]; g_reta[j]=t; } }
 void create_fat(void){ g_fat=(uint64_t*)rte_zmalloc_socket("fat", FAT_SIZE*sizeof(uint64_t), RTE_CACHE_LINE_SIZE, rte_socket_id()); if(!g_fat) rte_exit(EXIT_FAILURE, "FAT allocate failed: %s", rte_strerror(rte_errno)); }
-void banner(void){ time_t t=time(NULL); struct tm lt; localtime_r(&t,&lt); char ts[64]; strftime(ts,sizeof(ts), "%Y-%m-%d %H:%M:%S %Z", &lt); puts("[software-packet-distributor] XXH distributor (v1.9.7)"); printf(" time : %s", ts); putchar('\n'); printf(" generator core : %u", GEN_CORE); putchar('\n'); printf(" Distributor-A core : %u", DISTA_CORE); putchar('\n'); printf(" Distributor-B core : %u", DISTB_CORE); putchar('\n'); printf(" sink core : %u", SINK_CORE); putchar('\n'); printf(" perf core : %u", PERF_CORE); putchar('\n'); printf(" workers : "); for(unsigned i=0;i<NB_WORKERS;i++){ printf("%u%s", WORKERS[i], (i+1<NB_WORKERS)?",":""); } putchar('\n'); printf(" ring size : %u", RING_SIZE); putchar('\n'); printf(" pipeline size : %u", PIPE_SIZE); putchar('\n'); printf(" flows : %u (mice+elephants; power-of-two)", NFLOWS); putchar('\n'); puts("[config] elephants: ON (3 flows ~10% each)"); puts(" UDP/TCP: ~50/50 via wheel (1024 slots; shuffled; elephants weighted if ON)"); puts(" worker select: FAT hit -> worker ; miss -> RETA[XXH32(MSB-8) & mask]"); puts(" FAT: 2048 entries (8B each), 8-probe window, 5-bit modular age"); }
-void sanity_check(void){ unsigned counts[16]={0}; for(unsigned i=0;i<RETA_SZ;++i) counts[g_reta[i]]++; for(unsigned w=0; w<NB_WORKERS; ++w){ if(counts[w]==0){ printf("[sanity] RETA worker %u has 0 entries", w); putchar('\n'); } } if(rte_get_tsc_hz()==0){ puts("[sanity] invalid TSC hz (0)"); } if(!g_fat){ puts("[sanity] FAT not allocated"); } }
+void banner(void){ time_t t=time(NULL); struct tm lt; localtime_r(&t,&lt); char ts[64]; strftime(ts,sizeof(ts), "%Y-%m-%d %H:%M:%S %Z", &lt); puts("[software-packet-distributor] XXH distributor (v1.9.7)"); printf(" time : %s", ts); putchar('\n'); printf(" generator core : %u", GEN_CORE); putchar('\n'); printf(" Distributor-A core : %u", DISTA_CORE); putchar('\n'); printf(" Distributor-B core : %u", DISTB_CORE); putchar('\n'); printf(" perf core : %u", PERF_CORE); putchar('\n'); printf(" workers : "); for(unsigned i=0;i<NB_WORKERS;i++){ printf("%u%s", WORKERS[i], (i+1<NB_WORKERS)?",":""); } putchar('\n'); printf(" ring size : %u", RING_SIZE); putchar('\n'); printf(" pipeline size : %u", PIPE_SIZE); putchar('\n'); printf(" flows : %u (mice+elephants; power-of-two)", NFLOWS); putchar('\n'); puts("[config] elephants: ON (3 flows ~10% each)"); puts(" UDP/TCP: ~50/50 via wheel (1024 slots; shuffled; elephants weighted if ON)"); puts(" worker select: FAT hit -> worker ; miss -> RETA[XXH32(MSB-8) & mask]"); puts(" FAT: 2048 entries (8B each), 8-probe window, 5-bit modular age"); printf(" idle policy : %s", idle_policy_name(idle_policy_from_env())); putchar('\n'); printf(" egress : %s", egress_mode_name()); if(g_egress_mode==EGRESS_SINK){ printf(" (sinks="); for(unsigned k=0;k<g_nb_sinks;k++){ printf("%u%s", g_sink_cores[k], (k+1<g_nb_sinks)?",":""); } printf(", bulk free)"); } putchar('\n'); printf(" ring staging : fill=%u/%u/%u (ingress/pipe/worker) timeout=%u us zero-copy=%s", g_stage_fill[RING_INGRESS], g_stage_fill[RING_PIPE], g_stage_fill[RING_WORKER], (unsigned)g_stage_timeout_us, g_ring_zc?"on":"off"); putchar('\n'); const uint32_t stall_us=stall_us_from_env(); if(stall_us) printf(" stall detection : %u us without progress (poll %u us)", stall_us, HEALTH_POLL_US); else printf(" stall detection : off"); putchar('\n'); if(g_maglev_on){ printf(" worker select (miss) : Maglev[%u] weights=", g_maglev_size); for(unsigned i=0;i<NB_WORKERS;i++){ printf("%u%s", g_maglev_weight[i], (i+1<NB_WORKERS)?",":""); } putchar('\n'); } }
+void sanity_check(void){ unsigned counts[16]={0}; for(unsigned i=0;i<RETA_SZ;++i) counts[g_reta[i]]++; for(unsigned w=0; w<NB_WORKERS; ++w){ if(counts[w]==0){ printf("[sanity] RETA worker %u has 0 entries", w); putchar('\n'); } } if(rte_get_tsc_hz()==0){ puts("[sanity] invalid TSC hz (0)"); } if(!g_fat){ puts("[sanity] FAT not allocated"); } if(g_maglev_on){ unsigned mc[16]; maglev_counts(mc); for(unsigned w=0; w<NB_WORKERS; ++w){ if(g_maglev_weight[w] && mc[w]==0){ printf("[sanity] Maglev worker %u has 0 entries", w); putchar('\n'); } } } }
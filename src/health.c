@@ -0,0 +1,30 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#include "health.h"
+#include "globals.h"
+#include "fat.h"
+#include "maglev.h"
+#include "idle.h"
+worker_beat g_worker_beat[16]; volatile uint8_t g_worker_health[16]; int g_stall_inject_wi=-1;
+typedef struct wk_watch { uint64_t rx, beat, last_ok, drop_ok, drop_stall, stalled_at, quarantined_at, next_step; unsigned good, step, nevac; bool alive, evict_again; } wk_watch;
+static wk_watch g_watch[NB_WORKERS]; static uint8_t g_evac[NB_WORKERS][RETA_SZ];
+static uint64_t g_stall_cyc=0, g_step_cyc=0, g_inject_at=0; static uint32_t g_inject_ms=0; static bool g_health_on=false;
+uint32_t stall_us_from_env(void){ const char *s=getenv("STALL_US"); if(s && s[0]){ char *end=NULL; unsigned long v=strtoul(s,&end,0); if(end!=s && v<=1000000ul) return (uint32_t)v; } return STALL_DEFAULT_US; }
+const char* worker_health_name(unsigned wi){ switch(g_worker_health[wi]){ case WK_QUARANTINED: return "quarantined"; case WK_RECOVERING: return "recovering"; default: return "healthy"; } }
+/* STALL_INJECT=<worker index>:<after s>:<ms> freezes one worker once, for exercising detection and evacuation. */
+void health_init(void){ const uint64_t hz=rte_get_tsc_hz(), now=rte_get_tsc_cycles(); const uint32_t us=stall_us_from_env(); g_health_on=(us>0u); g_stall_cyc=(uint64_t)us*hz/1000000ull; g_step_cyc=(uint64_t)HEALTH_STEP_MS*hz/1000ull; memset(g_watch, 0, sizeof(g_watch)); memset(g_evac, 0, sizeof(g_evac)); for(unsigned wi=0; wi<NB_WORKERS; wi++){ g_worker_health[wi]=WK_HEALTHY; g_watch[wi].last_ok=now; g_watch[wi].rx=g_worker_rx[wi]; g_watch[wi].drop_ok=g_worker_drop[wi]; } const char *s=getenv("STALL_INJECT"); unsigned wi=0, after=0, ms=0; if(s && sscanf(s, "%u:%u:%u", &wi, &after, &ms)==3 && wi<NB_WORKERS && ms>0u){ g_inject_at=now+(uint64_t)after*hz; g_inject_ms=ms; rte_smp_wmb(); g_stall_inject_wi=(int)wi; } }
+void health_inject_stall(unsigned idx){ if(rte_get_tsc_cycles()<g_inject_at) return; g_stall_inject_wi=-1; printf("[health] injecting %u ms stall on worker %u", g_inject_ms, WORKERS[idx]); putchar('\n'); rte_delay_us_block(g_inject_ms*1000u); }
+static unsigned evac_count(unsigned wi){ unsigned n=0; for(unsigned i=0;i<RETA_SZ;i++) n+=g_evac[wi][i]; return n; }
+/* Every bucket the stalled worker owns goes to the healthy worker with the fewest buckets at that moment; the bucket is remembered so it can be handed back. */
+static unsigned evacuate_reta(unsigned wi){ unsigned cnt[16]={0}, moved=0; for(unsigned i=0;i<RETA_SZ;i++) cnt[g_reta[i]]++; for(unsigned i=0;i<RETA_SZ;i++){ if(g_reta[i]!=wi) continue; int to=-1; for(unsigned k=0;k<NB_WORKERS;k++){ if(k==wi || !worker_usable(k)) continue; if(to<0 || cnt[k]<cnt[to]) to=(int)k; } if(to<0) break; g_reta[i]=(uint8_t)to; cnt[to]++; g_evac[wi][i]=1; moved++; } rte_smp_wmb(); return moved; }
+static void quarantine(unsigned wi, uint64_t now, unsigned queued){ wk_watch *w=&g_watch[wi]; const double cyc_ms=(double)rte_get_tsc_hz()/1e3; const unsigned lc=WORKERS[wi]; g_worker_health[wi]=WK_QUARANTINED; const uint64_t t0=rte_get_tsc_cycles(); unsigned moved=g_maglev_on? maglev_set_ramp(wi, 0u) : evacuate_reta(wi); unsigned fat=fat_evict_worker((uint16_t)wi); const uint64_t t1=rte_get_tsc_cycles(); w->evict_again=true; w->good=0; w->stalled_at=w->last_ok; w->quarantined_at=now; w->drop_stall=w->drop_ok; w->nevac=evac_count(wi); PERF_LOG("[health] w%02u STALL detected: no progress for %.2f ms with %u queued (heartbeat %s) -> quarantined", lc, (double)(now-w->last_ok)/cyc_ms, queued, w->alive? "running":"stopped"); PERF_LOG("[health] w%02u evacuated %u %s and %u FAT tags in %.1f us (%.2f ms after last progress), lost=%llu pkts", lc, moved, g_maglev_on? "maglev entries":"RETA buckets", fat, (double)(t1-t0)*1e3/cyc_ms, (double)(t1-w->last_ok)/cyc_ms, (unsigned long long)(g_worker_drop[wi]-w->drop_ok)); if(!moved && (g_maglev_on || w->nevac==0u)) PERF_LOG("[health] w%02u no healthy worker could take its share; traffic stays put", lc); }
+/* Gradual return: HEALTH_RETURN_STEPS steps, HEALTH_STEP_MS apart, each giving back an equal slice of what was evacuated. */
+static void return_step(unsigned wi, uint64_t now){ wk_watch *w=&g_watch[wi]; const unsigned lc=WORKERS[wi]; w->step++; w->next_step=now+g_step_cyc; unsigned moved=0; if(g_maglev_on){ moved=maglev_set_ramp(wi, 100u*w->step/HEALTH_RETURN_STEPS); } else { unsigned want=(w->nevac*w->step+HEALTH_RETURN_STEPS-1u)/HEALTH_RETURN_STEPS, back=w->nevac-evac_count(wi); for(unsigned i=0;i<RETA_SZ && back<want;i++){ if(!g_evac[wi][i]) continue; g_reta[i]=(uint8_t)wi; for(unsigned k=0;k<NB_WORKERS;k++) g_evac[k][i]=0; back++; moved++; } rte_smp_wmb(); } PERF_LOG("[health] w%02u return step %u/%u: %u %s back", lc, w->step, HEALTH_RETURN_STEPS, moved, g_maglev_on? "maglev entries":"RETA buckets"); if(w->step>=HEALTH_RETURN_STEPS){ memset(g_evac[wi], 0, RETA_SZ); g_worker_health[wi]=WK_HEALTHY; PERF_LOG("[health] w%02u back in service", lc); } }
+/* Control-core poll: a worker whose ring holds packets but whose rx counter has not moved for STALL_US is quarantined. Time spent in a
+ * deliberate idle sleep/monitor wait (IDLE_POLICY) does not count unless the worker overstays its own deadline by STALL_US. After
+ * HEALTH_PROBATION_POLLS polls of progress (or an empty ring) it is brought back. A worker that stalls again mid-return is re-quarantined. */
+void health_tick(void){ if(!g_health_on) return; const uint64_t now=rte_get_tsc_cycles(); for(unsigned wi=0; wi<NB_WORKERS; wi++){ wk_watch *w=&g_watch[wi]; const uint64_t rx=g_worker_rx[wi], beat=g_worker_beat[wi].beat; const unsigned q=rte_ring_count(g_worker_rings[wi]); const bool progressed=(rx!=w->rx); w->alive=(beat!=w->beat); w->rx=rx; w->beat=beat; const uint64_t park=g_lcore_cycles[WORKERS[wi]].park_until; const bool parked=park && now<park+g_stall_cyc; if(progressed || q==0u || parked){ w->last_ok=now; w->drop_ok=g_worker_drop[wi]; } if(g_worker_health[wi]!=WK_QUARANTINED){ if(now-w->last_ok>=g_stall_cyc) quarantine(wi, now, q); else if(g_worker_health[wi]==WK_RECOVERING && now>=w->next_step) return_step(wi, now); continue; } if(w->evict_again){ fat_evict_worker((uint16_t)wi); w->evict_again=false; } w->good=(progressed || q==0u)? w->good+1u : 0u; if(w->good<HEALTH_PROBATION_POLLS) continue; const double cyc_ms=(double)rte_get_tsc_hz()/1e3; PERF_LOG("[health] w%02u recovered after %.1f ms (quarantined %.1f ms), lost=%llu pkts; returning its share in %u steps", WORKERS[wi], (double)(now-w->stalled_at)/cyc_ms, (double)(now-w->quarantined_at)/cyc_ms, (unsigned long long)(g_worker_drop[wi]-w->drop_stall), HEALTH_RETURN_STEPS); g_worker_health[wi]=WK_RECOVERING; w->step=0; w->next_step=now; } }
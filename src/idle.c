@@ -0,0 +1,47 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#include "idle.h"
+#include <rte_version.h>
+#include <rte_power.h>
+/* rte_power_monitor() is experimental in 21.08..22.x: build with -DALLOW_EXPERIMENTAL_API to get the monitor policy. */
+#if RTE_VERSION >= RTE_VERSION_NUM(21,8,0,0) && defined(ALLOW_EXPERIMENTAL_API)
+#include <rte_power_intrinsics.h>
+#include <rte_cpuflags.h>
+#define SPD_HAVE_POWER_MONITOR 1
+#endif
+lcore_cycles g_lcore_cycles[RTE_MAX_LCORE]; static int g_power_env=-1;
+static const char *const idle_names[IDLE_POLICY_COUNT]={"spin","pause","monitor","freq","sleep","adaptive"};
+const char* idle_policy_name(int policy){ return (policy>=0 && policy<IDLE_POLICY_COUNT)? idle_names[policy] : "?"; }
+static inline int idle_policy_from_env_impl(void){ const char *s=getenv("IDLE_POLICY"); if(!s || !s[0]) return IDLE_SPIN; for(int p=0;p<IDLE_POLICY_COUNT;p++){ if(strcasecmp(s,idle_names[p])==0) return p; } return IDLE_SPIN; }
+int idle_policy_from_env(void){ return idle_policy_from_env_impl(); }
+static unsigned idle_sleep_us_from_env(void){ const char *s=getenv("IDLE_SLEEP_US"); if(s && s[0]){ char *end=NULL; unsigned long v=strtoul(s,&end,10); if(end!=s && v>0 && v<=100000ul) return (unsigned)v; } return 50u; }
+/* rte_power_init() auto-detects through rte_power_set_env(), which only the first caller wins; with every role starting at once the
+ * others fail. Probe the environment once on the main lcore instead, so the per-lcore rte_power_init() calls just use it. */
+void idle_power_setup(void){ if(g_power_env>=0) return; static const enum power_management_env envs[]={ PM_ENV_ACPI_CPUFREQ, PM_ENV_PSTATE_CPUFREQ,
+#if RTE_VERSION >= RTE_VERSION_NUM(21,5,0,0)
+	PM_ENV_CPPC_CPUFREQ,
+#endif
+	PM_ENV_KVM_VM }; const unsigned lc=rte_lcore_id(); g_power_env=0; for(unsigned i=0;i<RTE_DIM(envs);i++){ if(rte_power_set_env(envs[i])!=0) continue; if(rte_power_init(lc)==0){ rte_power_exit(lc); g_power_env=1; return; } rte_power_unset_env(); } puts("[idle] rte_power unavailable, frequency scaling disabled"); }
+#ifdef SPD_HAVE_POWER_MONITOR
+/* Abort the monitor sleep if the producer tail already moved past our snapshot. */
+static int ring_tail_moved(const uint64_t val, const uint64_t opaque[RTE_POWER_MONITOR_OPAQUE_SZ]){ return ((uint32_t)val != (uint32_t)opaque[0]) ? -1 : 0; }
+static bool monitor_supported(void){ struct rte_cpu_intrinsics intr; rte_cpu_get_intrinsics_support(&intr); return intr.power_monitor != 0; }
+static bool idle_monitor(const struct rte_ring *r, uint64_t until){ struct rte_power_monitor_cond pmc; memset(&pmc,0,sizeof(pmc)); pmc.addr=(volatile void*)(uintptr_t)&r->prod.tail; pmc.opaque[0]=r->prod.tail; pmc.fn=ring_tail_moved; pmc.size=sizeof(uint32_t); if(rte_ring_count(r)) return true; return rte_power_monitor(&pmc, until)==0; }
+#else
+static bool monitor_supported(void){ return false; }
+static bool idle_monitor(const struct rte_ring *r, uint64_t until){ (void)r; (void)until; return false; }
+#endif
+void idle_init(idle_state *st, int policy){ memset(st,0,sizeof(*st)); st->policy=(uint8_t)policy; st->lcore=rte_lcore_id(); st->acct=&g_lcore_cycles[st->lcore<RTE_MAX_LCORE? st->lcore:0]; st->sleep_us=idle_sleep_us_from_env(); st->sleep_cyc=rte_get_tsc_hz()/1000000u*st->sleep_us; st->monitor_cyc=rte_get_tsc_hz()/1000000u*IDLE_MONITOR_US; st->monitor_ok=(uint8_t)((policy==IDLE_MONITOR || policy==IDLE_ADAPTIVE) && monitor_supported()); if(policy==IDLE_FREQ || policy==IDLE_ADAPTIVE){ st->power_ok=(uint8_t)(g_power_env>0 && rte_power_init(st->lcore)==0); if(!st->power_ok && g_power_env!=0){ printf("[idle] lcore %u: rte_power unavailable, frequency scaling disabled", st->lcore); putchar('\n'); } } st->last=rte_get_tsc_cycles(); }
+void idle_wake(idle_state *st){ if(st->freq_low){ rte_power_freq_max(st->lcore); st->freq_low=0; st->acct->deep+=rte_get_tsc_cycles()-st->deep_since; } st->empty_run=0; }
+void idle_fini(idle_state *st){ idle_wake(st); if(st->power_ok){ rte_power_exit(st->lcore); st->power_ok=0; } }
+static inline void deep_charge(idle_state *st, uint64_t t0){ if(!st->freq_low) st->acct->deep+=rte_get_tsc_cycles()-t0; }
+static inline void freq_down(idle_state *st){ if(st->power_ok && !st->freq_low){ rte_power_freq_min(st->lcore); st->freq_low=1; st->deep_since=rte_get_tsc_cycles(); } }
+static inline void monitor_or_pause(idle_state *st, const struct rte_ring *r){ if(r && st->monitor_ok){ uint64_t t0=rte_get_tsc_cycles(); st->acct->park_until=t0+st->monitor_cyc; bool ok=idle_monitor(r, t0+st->monitor_cyc); st->acct->park_until=0; if(ok){ deep_charge(st,t0); return; } } rte_pause(); }
+static inline void sleep_us(idle_state *st){ uint64_t t0=rte_get_tsc_cycles(); st->acct->park_until=t0+st->sleep_cyc; rte_delay_us_sleep(st->sleep_us); st->acct->park_until=0; deep_charge(st,t0); }
+/* One empty poll: back off according to policy and charge the elapsed cycles as idle. r (may be NULL) is the ring to monitor. */
+void idle_wait(idle_state *st, const struct rte_ring *r){ if(st->empty_run<UINT32_MAX) st->empty_run++; const uint32_t run=st->empty_run; switch(st->policy){ case IDLE_PAUSE: { unsigned k=(run<IDLE_SPIN_POLLS)? 1u : RTE_MIN(run/IDLE_SPIN_POLLS, 64u); for(unsigned i=0;i<k;i++) rte_pause(); break; } case IDLE_MONITOR: if(run<IDLE_SPIN_POLLS) rte_pause(); else monitor_or_pause(st,r); break; case IDLE_FREQ: if(run>=IDLE_SPIN_POLLS) freq_down(st); rte_pause(); break; case IDLE_SLEEP: if(run<IDLE_SPIN_POLLS) rte_pause(); else sleep_us(st); break; case IDLE_ADAPTIVE: if(run<IDLE_SPIN_POLLS){ rte_pause(); } else if(run<IDLE_MONITOR_POLLS){ monitor_or_pause(st,r); } else { freq_down(st); if(run<IDLE_SLEEP_POLLS) monitor_or_pause(st,r); else sleep_us(st); } break; default: rte_pause(); break; } idle_mark(st,false); }
+double lcore_util_pct(unsigned lcore, uint64_t *prev_busy, uint64_t *prev_idle){ if(lcore>=RTE_MAX_LCORE) return 0.0; uint64_t b=g_lcore_cycles[lcore].busy, i=g_lcore_cycles[lcore].idle; uint64_t db=b-*prev_busy, di=i-*prev_idle; *prev_busy=b; *prev_idle=i; return (db+di)? 100.0*(double)db/(double)(db+di) : 0.0; }
@@ -0,0 +1,34 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#include "maglev.h"
+#include "globals.h"
+#include "hash.h"
+#include "fat.h"
+bool g_maglev_on=false; uint8_t *g_maglev=NULL; uint32_t g_maglev_size=0; uint16_t g_maglev_weight[16];
+static uint8_t *g_maglev_shadow=NULL; static uint32_t g_mg_offset[16], g_mg_skip[16]; static uint8_t g_maglev_ramp[16];
+static inline bool maglev_enabled_impl(void){ const char *s=getenv("LB_TABLE"); if(!s) return false; return strcasecmp(s,"maglev")==0; }
+bool maglev_enabled(void){ return maglev_enabled_impl(); }
+static bool is_prime(uint32_t n){ if(n<2u) return false; if((n&1u)==0u) return n==2u; for(uint32_t d=3; (uint64_t)d*d<=n; d+=2){ if(n%d==0u) return false; } return true; }
+uint32_t maglev_round_size(uint32_t m){ while(!is_prime(m)) m++; return m; }
+uint32_t maglev_size_from_env(void){ uint32_t m=MAGLEV_DEFAULT_SIZE; const char *s=getenv("MAGLEV_SIZE"); if(s && s[0]){ char *end=NULL; unsigned long v=strtoul(s,&end,0); if(end!=s && v>=RETA_SZ && v<=MAGLEV_MAX_SIZE) m=(uint32_t)v; } return maglev_round_size(m); }
+void maglev_weights_from_env(uint16_t *w){ for(unsigned i=0;i<NB_WORKERS;i++) w[i]=1; const char *s=getenv("WORKER_WEIGHTS"); if(!s || !s[0]) return; for(unsigned i=0;i<NB_WORKERS && *s;i++){ char *end=NULL; unsigned long v=strtoul(s,&end,10); if(end==s) break; w[i]=(uint16_t)RTE_MIN(v,1000ul); s=end; if(*s==',') s++; } unsigned sum=0; for(unsigned i=0;i<NB_WORKERS;i++) sum+=w[i]; if(!sum){ puts("[maglev] WORKER_WEIGHTS are all zero; using 1 for every worker"); for(unsigned i=0;i<NB_WORKERS;i++) w[i]=1; } }
+/* j-th preference of worker i; M prime and 1 <= skip < M make every row a full permutation of the table. */
+static inline uint32_t perm(unsigned i, uint32_t j){ return (uint32_t)(((uint64_t)g_mg_offset[i] + (uint64_t)j*g_mg_skip[i]) % g_maglev_size); }
+static void populate(uint8_t *t, const uint16_t *w){ const uint32_t M=g_maglev_size; uint32_t next[16]={0}, credit[16]={0}, filled=0; uint16_t wmax=0; for(unsigned i=0;i<NB_WORKERS;i++) if(w[i]>wmax) wmax=w[i]; memset(t, MAGLEV_FREE, M); if(!wmax) return; while(filled<M){ for(unsigned i=0;i<NB_WORKERS && filled<M;i++){ if(!w[i]) continue; credit[i]+=w[i]; while(credit[i]>=wmax && filled<M){ credit[i]-=wmax; uint32_t s; do { s=perm(i,next[i]++); } while(t[s]!=MAGLEV_FREE); t[s]=(uint8_t)i; filled++; } } } }
+/* Publish shadow -> live one byte at a time: a concurrent reader sees either the old or the new worker, never MAGLEV_FREE. */
+static unsigned apply_shadow(void){ unsigned moved=0; for(uint32_t s=0;s<g_maglev_size;s++){ if(g_maglev[s]!=g_maglev_shadow[s]){ g_maglev[s]=g_maglev_shadow[s]; moved++; } } rte_smp_wmb(); return moved; }
+static void targets(const uint32_t *w, uint32_t *tgt){ const uint32_t M=g_maglev_size; uint64_t W=0; uint32_t sum=0; for(unsigned i=0;i<NB_WORKERS;i++) W+=w[i]; for(unsigned i=0;i<NB_WORKERS;i++){ tgt[i]=W? (uint32_t)((uint64_t)M*w[i]/W) : 0u; sum+=tgt[i]; } for(unsigned i=0; W && sum<M; i=(i+1u)%NB_WORKERS){ if(w[i]){ tgt[i]++; sum++; } } }
+void maglev_build(const uint16_t *weights){ memcpy(g_maglev_weight, weights, NB_WORKERS*sizeof(uint16_t)); populate(g_maglev_shadow, g_maglev_weight); apply_shadow(); }
+void maglev_init(uint32_t size, const uint16_t *weights){ uint32_t wsum=0; for(unsigned i=0;i<NB_WORKERS;i++) wsum+=weights[i]; if(!wsum) rte_exit(EXIT_FAILURE, "maglev: all worker weights are zero"); rte_free(g_maglev); rte_free(g_maglev_shadow); g_maglev_size=size; g_maglev=(uint8_t*)rte_zmalloc_socket("maglev", size, RTE_CACHE_LINE_SIZE, rte_socket_id()); g_maglev_shadow=(uint8_t*)rte_zmalloc_socket("maglev_shadow", size, RTE_CACHE_LINE_SIZE, rte_socket_id()); if(!g_maglev || !g_maglev_shadow) rte_exit(EXIT_FAILURE, "maglev table allocate failed: %s", rte_strerror(rte_errno)); for(unsigned i=0;i<NB_WORKERS;i++){ uint32_t id=WORKERS[i]; g_mg_offset[i]=xxh32(&id,sizeof(id),0x4D41474Cu) % size; g_mg_skip[i]=xxh32(&id,sizeof(id),0x534B4950u) % (size-1u) + 1u; } memcpy(g_maglev_weight, weights, NB_WORKERS*sizeof(uint16_t)); memset(g_maglev_ramp, 100, sizeof(g_maglev_ramp)); populate(g_maglev, g_maglev_weight); g_maglev_on=true; }
+/* Incremental rebuild: over-target workers release their least-preferred slots, under-target workers claim free slots in preference
+ * order (round-robin), so only the weight delta moves. Targets use weight x ramp%. Returns entries moved, or -1 if no weight is left. */
+static int rebalance(void){ const uint32_t M=g_maglev_size; uint32_t eff[16]; uint64_t W=0; for(unsigned i=0;i<NB_WORKERS;i++){ eff[i]=(uint32_t)g_maglev_weight[i]*g_maglev_ramp[i]; W+=eff[i]; } if(!W) return -1; uint8_t *t=g_maglev_shadow; memcpy(t, g_maglev, M); uint32_t cnt[16]={0}, tgt[16], pos[16]={0}; for(uint32_t s=0;s<M;s++) if(t[s]<NB_WORKERS) cnt[t[s]]++; targets(eff, tgt); for(unsigned i=0;i<NB_WORKERS;i++){ for(uint32_t j=M; cnt[i]>tgt[i] && j-- > 0;){ uint32_t s=perm(i,j); if(t[s]==i){ t[s]=MAGLEV_FREE; cnt[i]--; } } } for(bool pending=true; pending;){ pending=false; for(unsigned i=0;i<NB_WORKERS;i++){ while(cnt[i]<tgt[i] && pos[i]<M){ uint32_t s=perm(i,pos[i]++); if(t[s]==MAGLEV_FREE){ t[s]=(uint8_t)i; cnt[i]++; break; } } if(cnt[i]<tgt[i] && pos[i]<M) pending=true; } } return (int)apply_shadow(); }
+/* Dropping a worker to 0 also retires its FAT tags. */
+unsigned maglev_set_weight(unsigned wi, uint16_t w){ if(!g_maglev || wi>=NB_WORKERS) return 0u; uint16_t prev=g_maglev_weight[wi]; g_maglev_weight[wi]=w; int moved=rebalance(); if(moved<0){ g_maglev_weight[wi]=prev; return 0u; } if(!w) fat_evict_worker((uint16_t)wi); return (unsigned)moved; }
+/* Temporary share scaling (0..100%) on top of the configured weight, e.g. to drain a worker and bring it back in steps. */
+unsigned maglev_set_ramp(unsigned wi, unsigned pct){ if(!g_maglev || wi>=NB_WORKERS) return 0u; uint8_t prev=g_maglev_ramp[wi]; g_maglev_ramp[wi]=(uint8_t)RTE_MIN(pct,100u); int moved=rebalance(); if(moved<0){ g_maglev_ramp[wi]=prev; return 0u; } return (unsigned)moved; }
+void maglev_counts(unsigned *cnt){ for(unsigned i=0;i<NB_WORKERS;i++) cnt[i]=0; for(uint32_t s=0;s<g_maglev_size;s++) if(g_maglev[s]<NB_WORKERS) cnt[g_maglev[s]]++; }
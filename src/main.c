@@ -10,5 +10,12 @@
 #include "core_generator.h"
 #include "perf.h"
 #include "flow.h"
+#include "bench.h"
+#include "seqchk.h"
+#include "maglev.h"
+#include "egress.h"
+#include "stage.h"
+#include "health.h"
+#include "idle.h"
 static void on_signal(int sig){ (void)sig; g_quit = 1; rte_smp_wmb(); }
-int main(int argc, char **argv){ signal(SIGINT, on_signal); signal(SIGTERM, on_signal); int ret=rte_eal_init(argc, argv); if(ret<0) rte_exit(EXIT_FAILURE, "EAL init failed"); setvbuf(stdout, NULL, _IOLBF, 0); build_flows_and_wheel(); build_header_templates(); build_reta(); banner(); if(!rte_lcore_is_enabled(PERF_CORE) || !rte_lcore_is_enabled(DISTA_CORE) || !rte_lcore_is_enabled(DISTB_CORE) || !rte_lcore_is_enabled(GEN_CORE) || !rte_lcore_is_enabled(SINK_CORE)) rte_exit(EXIT_FAILURE, "Perf/Distributor-A/Distributor-B/generator/sink core not enabled (-l)." ); for(unsigned i=0;i<NB_WORKERS;i++){ if(!rte_lcore_is_enabled(WORKERS[i])) rte_exit(EXIT_FAILURE, "Worker core %u not enabled (-l).", WORKERS[i]); } create_mempools(); create_rings(); create_fat(); sanity_check(); for(unsigned i=0;i<NB_WORKERS;i++){ rte_eal_remote_launch(worker_main, (void*)(uintptr_t)i, WORKERS[i]); } rte_eal_remote_launch(distB_main, NULL, DISTB_CORE); rte_eal_remote_launch(distA_main, NULL, DISTA_CORE); rte_eal_remote_launch(perf_main, NULL, PERF_CORE); rte_eal_remote_launch(gen_main, NULL, GEN_CORE); rte_eal_remote_launch(sink_main, NULL, SINK_CORE); rte_eal_mp_wait_lcore(); rte_eal_cleanup(); return 0; }
+int main(int argc, char **argv){ signal(SIGINT, on_signal); signal(SIGTERM, on_signal); int ret=rte_eal_init(argc, argv); if(ret<0) rte_exit(EXIT_FAILURE, "EAL init failed"); setvbuf(stdout, NULL, _IOLBF, 0); egress_config_from_env(); stage_config_from_env(); { const int ip=idle_policy_from_env(); if(ip==IDLE_FREQ || ip==IDLE_ADAPTIVE) idle_power_setup(); } build_flows_and_wheel(); build_header_templates(); build_reta(); if(maglev_enabled()){ uint16_t w[16]; maglev_weights_from_env(w); maglev_init(maglev_size_from_env(), w); } banner(); const char *bench=bench_requested(); if(bench){ int rc=run_bench(bench); rte_eal_cleanup(); return rc<0? EXIT_FAILURE:0; } if(!rte_lcore_is_enabled(PERF_CORE) || !rte_lcore_is_enabled(DISTA_CORE) || !rte_lcore_is_enabled(DISTB_CORE) || !rte_lcore_is_enabled(GEN_CORE)) rte_exit(EXIT_FAILURE, "Perf/Distributor-A/Distributor-B/generator core not enabled (-l)." ); for(unsigned k=0;g_egress_mode==EGRESS_SINK && k<g_nb_sinks;k++){ if(!rte_lcore_is_enabled(g_sink_cores[k])) rte_exit(EXIT_FAILURE, "Sink core %u not enabled (-l).", g_sink_cores[k]); } for(unsigned i=0;i<NB_WORKERS;i++){ if(!rte_lcore_is_enabled(WORKERS[i])) rte_exit(EXIT_FAILURE, "Worker core %u not enabled (-l).", WORKERS[i]); } create_mempools(); create_rings(); create_fat(); if(seq_check_enabled()){ if(g_egress_mode==EGRESS_SINK && g_nb_sinks==1u) seq_init(seq_flows_from_env()); else puts("[seq] checker needs EGRESS=sink with a single sink core; disabled"); } sanity_check(); health_init(); for(unsigned i=0;i<NB_WORKERS;i++){ rte_eal_remote_launch(worker_main, (void*)(uintptr_t)i, WORKERS[i]); } rte_eal_remote_launch(distB_main, NULL, DISTB_CORE); rte_eal_remote_launch(distA_main, NULL, DISTA_CORE); rte_eal_remote_launch(perf_main, NULL, PERF_CORE); rte_eal_remote_launch(gen_main, NULL, GEN_CORE); for(unsigned k=0;g_egress_mode==EGRESS_SINK && k<g_nb_sinks;k++){ int rc=rte_eal_remote_launch(sink_main, (void*)(uintptr_t)k, g_sink_cores[k]); if(rc!=0) rte_exit(EXIT_FAILURE, "sink launch on lcore %u failed: %s", g_sink_cores[k], rte_strerror(-rc)); } rte_eal_mp_wait_lcore(); rte_eal_cleanup(); return 0; }
@@ -0,0 +1,32 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#include "parse.h"
+#define ET_IPV4 0x0800u
+#define ET_IPV6 0x86DDu
+#define ET_VLAN 0x8100u
+#define ET_QINQ 0x88A8u
+#define ET_QINQ_OLD 0x9100u
+#define ET_TEB 0x6558u
+#define IPP_TCP 6u
+#define IPP_UDP 17u
+#define IPP_GRE 47u
+#define IPP_SCTP 132u
+#define UDP_PORT_VXLAN 4789u
+#define UDP_PORT_GTPU 2152u
+static inline bool tunnel_hash_enabled_impl(void){ const char *s=getenv("TUNNEL_HASH"); if(!s) return false; return strcasecmp(s,"on")==0; }
+bool tunnel_hash_enabled(void){ return tunnel_hash_enabled_impl(); }
+static inline uint16_t rd16(const uint8_t *p){ return (uint16_t)(((uint16_t)p[0]<<8) | p[1]); }
+static inline bool has_ports(uint8_t proto){ return proto==IPP_TCP || proto==IPP_UDP || proto==IPP_SCTP; }
+/* IPv6 extension headers walked before the upper-layer protocol (hop-by-hop, routing, fragment, dest-opts). The walk stops at a
+ * real Fragment header: what follows it is only present in the first fragment, so its next-header byte is the key protocol for all. */
+static inline bool v6_ext(uint8_t nh){ return nh==0u || nh==43u || nh==44u || nh==60u; }
+static int parse_l3(const uint8_t *f, const uint8_t *ip, const uint8_t *end, uint16_t et, pkt_meta *m){ const uint8_t *l4; uint8_t proto, frag=0; unsigned alen; if(et==ET_IPV4){ if(end-ip<20) return 0; unsigned ihl=(unsigned)(ip[0]&0x0F)*4u; if(unlikely(ihl<20u || (unsigned)(end-ip)<ihl)) return 0; proto=ip[9]; frag=(uint8_t)((rd16(ip+6)&0x3FFFu)!=0u); memcpy(m->key, ip+12, 8); alen=8; l4=ip+ihl; } else if(et==ET_IPV6){ if(end-ip<40) return 0; proto=ip[6]; l4=ip+40; for(unsigned k=0; k<4u && v6_ext(proto); k++){ if(end-l4<8) return 0; if(proto==44u){ frag|=(uint8_t)((rd16(l4+2)&0xFFF9u)!=0u); proto=l4[0]; l4+=8; if(frag) break; } else { unsigned el=((unsigned)l4[1]+1u)*8u; proto=l4[0]; if((unsigned)(end-l4)<el) return 0; l4+=el; } } memcpy(m->key, ip+8, 32); alen=32; } else { return 0; } m->key[alen]=proto; m->klen=(uint8_t)(alen+1u); m->l3=(et==ET_IPV4)?L3_IPV4:L3_IPV6; m->proto=proto; m->frag=frag; m->l3_off=(uint16_t)(ip-f); m->l4_off=(uint16_t)(l4-f); if(!frag && has_ports(proto) && end-l4>=4){ memcpy(m->key+m->klen, l4, 4); m->klen=(uint8_t)(m->klen+4u); } return 1; }
+static int parse_l2(const uint8_t *f, const uint8_t *p, const uint8_t *end, pkt_meta *m){ if(end-p<14) return 0; uint16_t et=rd16(p+12); const uint8_t *l3=p+14; uint8_t vl=0; while(vl<2u && (et==ET_VLAN || et==ET_QINQ || et==ET_QINQ_OLD)){ if(end-l3<4) return 0; et=rd16(l3+2); l3+=4; vl++; } m->vlans=vl; m->l2_len=(uint16_t)(l3-p); if(parse_l3(f, l3, end, et, m)) return 1; memcpy(m->key, p, 12); m->key[12]=(uint8_t)(et>>8); m->key[13]=(uint8_t)et; m->klen=14; m->l3=L3_NONE; m->proto=0; m->frag=0; m->l3_off=m->l4_off=(uint16_t)(l3-f); return 1; }
+/* Inner-flow decode for VXLAN (UDP/4789), GTP-U (UDP/2152, G-PDU) and GRE (v0, IP or TEB payload); one level deep. */
+static int parse_tunnel(const uint8_t *f, const uint8_t *end, const pkt_meta *m, pkt_meta *in){ const uint8_t *l4=f+m->l4_off; if(m->proto==IPP_UDP){ if(end-l4<16) return 0; uint16_t dp=rd16(l4+2); const uint8_t *h=l4+8; if(dp==UDP_PORT_VXLAN){ if(!(h[0]&0x08)) return 0; return parse_l2(f, h+8, end, in) && in->l3!=L3_NONE ? TUN_VXLAN : 0; } if(dp==UDP_PORT_GTPU){ if((h[0]>>5)!=1u || !(h[0]&0x10) || h[1]!=0xFF) return 0; const uint8_t *x=h+8; if(h[0]&0x07){ if(end-x<4) return 0; uint8_t nx=x[3]; x+=4; for(unsigned k=0; nx && k<4u; k++){ if(end-x<4) return 0; unsigned el=(unsigned)x[0]*4u; if(!el || (unsigned)(end-x)<el) return 0; nx=x[el-1u]; x+=el; } if(nx) return 0; } if(end-x<1) return 0; uint16_t et=((x[0]>>4)==4u)?ET_IPV4:((x[0]>>4)==6u)?ET_IPV6:0u; return parse_l3(f, x, end, et, in) ? TUN_GTPU : 0; } return 0; } if(m->proto==IPP_GRE){ if(end-l4<4) return 0; uint16_t fl=rd16(l4); if(fl&0x0007u) return 0; uint16_t pt=rd16(l4+2); const uint8_t *x=l4+4+((fl&0x8000u)?4:0)+((fl&0x2000u)?4:0)+((fl&0x1000u)?4:0); if(x>end) return 0; if(pt==ET_TEB) return parse_l2(f, x, end, in) && in->l3!=L3_NONE ? TUN_GRE : 0; return parse_l3(f, x, end, pt, in) ? TUN_GRE : 0; } return 0; }
+void parse_frame(const uint8_t *f, uint32_t len, pkt_meta *m, bool inner){ const uint8_t *end=f+len; m->klen=0; m->tun=TUN_NONE; if(unlikely(!parse_l2(f, f, end, m))){ m->l3=L3_NONE; m->l2_len=m->l3_off=m->l4_off=0; m->vlans=m->proto=m->frag=0; return; } if(!inner || m->frag || (m->proto!=IPP_UDP && m->proto!=IPP_GRE)) return; pkt_meta in; int t=parse_tunnel(f, end, m, &in); if(t){ memcpy(m->key, in.key, in.klen); m->klen=in.klen; m->tun=(uint8_t)t; } }
+void parse_burst(struct rte_mbuf **pkts, unsigned n, pkt_meta *meta, bool inner){ for(unsigned i=0;i<n && i<4u;i++) rte_prefetch0(rte_pktmbuf_mtod(pkts[i], void*)); for(unsigned i=0;i<n;i++){ if(likely(i+4u<n)) rte_prefetch0(rte_pktmbuf_mtod(pkts[i+4u], void*)); parse_frame(rte_pktmbuf_mtod(pkts[i], const uint8_t*), pkts[i]->data_len, &meta[i], inner); } }
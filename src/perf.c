@@ -8,9 +8,18 @@
 #include "globals.h"
 #include "flow.h"
 #include "core_distributor.h"
+#include "idle.h"
+#include "seqchk.h"
+#include "maglev.h"
+#include "egress.h"
+#include "stage.h"
+#include "health.h"
 static inline bool greedy_enabled_impl(void){ const char *s=getenv("GREEDY"); if(!s) return true; return strcasecmp(s,"on")==0; }
 bool greedy_enabled(void){ return greedy_enabled_impl(); }
 static void ensure_dir(const char *path){ struct stat st; if (stat(path,&st)==0) return; (void)mkdir(path,0755); }
-static FILE* open_csv(const char *path){ ensure_dir("/var/log/software-packet-distributor"); FILE *f=fopen(path,"a"); if(!f) return NULL; fseek(f,0,SEEK_END); long sz=ftell(f); if(sz<=0){ fputs("epoch,worker,rx_kpps,tx_kpps,drops,flows,fat_hits,fat_misses,fat_evictions", f); fputc('\n', f); fflush(f);} return f; }
-unsigned greedy_reshaper_tick(const double *rx_vals, unsigned max_moves){ if(!greedy_enabled()) return 0u; unsigned hot=0,cold=0; double hot_v=rx_vals[0], cold_v=rx_vals[0]; for(unsigned wi=1; wi<NB_WORKERS; wi++){ if(rx_vals[wi]>hot_v){ hot_v=rx_vals[wi]; hot=wi; } if(rx_vals[wi]<cold_v){ cold_v=rx_vals[wi]; cold=wi; } } if(hot==cold) return 0u; unsigned moves=0; unsigned start=(unsigned)(0xC0FFEE11u & RETA_MASK); for(unsigned i=0;i<RETA_SZ && moves<max_moves;i++){ unsigned idx=(start+i) & RETA_MASK; if(g_reta[idx]==hot){ g_reta[idx]=(uint8_t)cold; moves++; } } return moves; }
-int perf_main(void *arg){ (void)arg; puts("[perf] started"); const uint64_t hz=rte_get_tsc_hz(); uint64_t last_1s=rte_get_tsc_cycles(); uint64_t rx1[16]={0}, tx1[16]={0}, d1[16]={0}; uint64_t gen_tx1=0, gen_dp1=0, dist_rx1=0, dist_tx1=0, dist_dp1=0; uint64_t fat_hit1=0, fat_mis1=0, fat_evc1=0; unsigned seconds_seen=0; FILE *csv=open_csv("/var/log/software-packet-distributor/worker_stats_v105.csv"); while(!g_quit){ rte_delay_us_block(100000); uint64_t now=rte_get_tsc_cycles(); uint64_t delta=now-last_1s; if(delta<hz) continue; unsigned ticks=(unsigned)(delta/hz); double sec_1s=(double)ticks; last_1s += (uint64_t)ticks*hz; for(unsigned t=0;t<ticks;++t){ unsigned cur=seconds_seen+t+1u; unsigned sec_idx=(cur-1u)&7u; unsigned cycle_idx=(cur-1u)/8u; mutate_flows_chunk(sec_idx, cycle_idx);} seconds_seen+=ticks; time_t epoch=time(NULL); double wrx_sum=0,wtx_sum=0, wdp_sum=0; double rx_vals[16]; for(unsigned wi=0; wi<NB_WORKERS; wi++){ uint64_t rx_d=g_worker_rx[wi]-rx1[wi]; rx1[wi]=g_worker_rx[wi]; uint64_t tx_d=g_worker_tx[wi]-tx1[wi]; tx1[wi]=g_worker_tx[wi]; uint64_t dp_d=g_worker_drop[wi]-d1[wi]; d1[wi]=g_worker_drop[wi]; double rx_kpps=(sec_1s>0? (double)rx_d/sec_1s:0)/1e3; double tx_kpps=(sec_1s>0? (double)tx_d/sec_1s:0)/1e3; double dp_kpps=(sec_1s>0? (double)dp_d/sec_1s:0)/1e3; wrx_sum+=rx_kpps; wtx_sum+=tx_kpps; wdp_sum+=dp_kpps; rx_vals[wi]=rx_kpps; PERF_LOG("[perf] w%02u rx=%.2f Kpps tx=%.2f Kpps drop=%.2f Kpps flows=%u", WORKERS[wi], rx_kpps, tx_kpps, dp_kpps, (unsigned)g_flow_count_shadow[wi]); if(csv){ fprintf(csv, "%ld,%u,%.3f,%.3f,%.3f,%u,%llu,%llu,%llu", (long)epoch, WORKERS[wi], rx_kpps, tx_kpps, dp_kpps, (unsigned)g_flow_count_shadow[wi], (unsigned long long)(g_fat_hits - fat_hit1), (unsigned long long)(g_fat_misses - fat_mis1), (unsigned long long)(g_fat_evictions - fat_evc1)); fputc('\n', csv);} } uint64_t gtx_d=g_gen_tx-gen_tx1; gen_tx1=g_gen_tx; uint64_t gdp_d=g_gen_drop-gen_dp1; gen_dp1=g_gen_drop; uint64_t drx_d=g_dist_rx-dist_rx1; dist_rx1=g_dist_rx; uint64_t dtx_d=g_dist_tx-dist_tx1; dist_tx1=g_dist_tx; uint64_t ddp_d=g_dist_drop-dist_dp1; dist_dp1=g_dist_drop; double gen_tx_mpps=(sec_1s>0? (double)gtx_d/sec_1s:0)/1e6; double gen_dp_mpps=(sec_1s>0? (double)gdp_d/sec_1s:0)/1e6; double dist_rx_mpps=(sec_1s>0? (double)drx_d/sec_1s:0)/1e6; double dist_tx_mpps=(sec_1s>0? (double)dtx_d/sec_1s:0)/1e6; double dist_dp_mpps=(sec_1s>0? (double)ddp_d/sec_1s:0)/1e6; PERF_LOG("[perf] gen tx=%.2f Mpps drop=%.2f Mpps", gen_tx_mpps, gen_dp_mpps); PERF_LOG("[perf] dist rx=%.2f Mpps tx=%.2f Mpps drop=%.2f Mpps", dist_rx_mpps, dist_tx_mpps, dist_dp_mpps); double mean=wrx_sum/(double)NB_WORKERS; double var=0.0; for(unsigned wi=0; wi<NB_WORKERS; wi++){ double d=rx_vals[wi]-mean; var+=d*d; } var/=(double)NB_WORKERS; double sd=sqrt(var); PERF_LOG("[perf] workers rx stddev=%.2f Kpps", sd); double fmean=0.0; for(unsigned wi=0; wi<NB_WORKERS; wi++) fmean+=(double)g_flow_count_shadow[wi]; fmean/=(double)NB_WORKERS; double fvar=0.0; for(unsigned wi=0; wi<NB_WORKERS; wi++){ double fd=(double)g_flow_count_shadow[wi]-fmean; fvar+=fd*fd; } fvar/=(double)NB_WORKERS; double fsd=sqrt(fvar); PERF_LOG("[perf] workers flows stddev=%.2f", fsd); uint64_t fat_hit_d=g_fat_hits-fat_hit1; fat_hit1=g_fat_hits; uint64_t fat_mis_d=g_fat_misses-fat_mis1; fat_mis1=g_fat_misses; uint64_t fat_evc_d=g_fat_evictions-fat_evc1; fat_evc1=g_fat_evictions; double hits_M=(double)fat_hit_d/1e6; double mis_M=(double)fat_mis_d/1e6; double evc_M=(double)fat_evc_d/1e6; PERF_LOG("[perf] FAT hits=%.2fM misses=%.2fM evictions=%.2fM", hits_M, mis_M, evc_M); g_epoch += ticks; for(unsigned wi=0; wi<NB_WORKERS; wi++){ g_flow_count_shadow[wi]=g_flow_count[wi]; g_flow_count[wi]=0; } unsigned moves=greedy_enabled()? greedy_reshaper_tick(rx_vals, 8u):0u; printf("[reta] greedy moves=%u", moves); putchar('\n'); if(csv){ fflush(csv);} } if(csv) fclose(csv); return 0; }
+static const char CSV_HEADER[]="epoch,worker,rx_kpps,tx_kpps,drops,flows,fat_hits,fat_misses,fat_evictions,util_pct";
+/* A log written with a different column layout is moved aside to <path>.1 so every file has exactly one header. */
+static FILE* open_csv(const char *path){ ensure_dir("/var/log/software-packet-distributor"); FILE *f=fopen(path,"r"); if(f){ char line[256]; const size_t hl=sizeof(CSV_HEADER)-1u; bool same=(fgets(line,sizeof(line),f)==NULL) || (strncmp(line,CSV_HEADER,hl)==0 && (line[hl]=='\n' || line[hl]=='\r' || line[hl]=='\0')); fclose(f); if(!same){ char old[512]; snprintf(old,sizeof(old),"%s.1",path); if(rename(path,old)!=0){ printf("[perf] %s has a different column layout and could not be moved (%s); CSV disabled", path, strerror(errno)); putchar('\n'); return NULL; } printf("[perf] %s has a different column layout; moved it to %s", path, old); putchar('\n'); } } f=fopen(path,"a"); if(!f) return NULL; fseek(f,0,SEEK_END); long sz=ftell(f); if(sz<=0){ fputs(CSV_HEADER, f); fputc('\n', f); fflush(f);} return f; }
+/* Quarantined or recovering workers are neither hot nor cold: a stalled worker looks cold but must never receive buckets. */
+unsigned greedy_reshaper_tick(const double *rx_vals, unsigned max_moves){ if(!greedy_enabled() || g_maglev_on) return 0u; int hot=-1,cold=-1; double hot_v=0.0, cold_v=0.0; for(unsigned wi=0; wi<NB_WORKERS; wi++){ if(!worker_usable(wi)) continue; if(hot<0 || rx_vals[wi]>hot_v){ hot_v=rx_vals[wi]; hot=(int)wi; } if(cold<0 || rx_vals[wi]<cold_v){ cold_v=rx_vals[wi]; cold=(int)wi; } } if(hot<0 || hot==cold) return 0u; unsigned moves=0; unsigned start=(unsigned)(0xC0FFEE11u & RETA_MASK); for(unsigned i=0;i<RETA_SZ && moves<max_moves;i++){ unsigned idx=(start+i) & RETA_MASK; if(g_reta[idx]==hot){ g_reta[idx]=(uint8_t)cold; moves++; } } return moves; }
+int perf_main(void *arg){ (void)arg; puts("[perf] started"); const uint64_t hz=rte_get_tsc_hz(); uint64_t last_1s=rte_get_tsc_cycles(); uint64_t rx1[16]={0}, tx1[16]={0}, d1[16]={0}; uint64_t gen_tx1=0, gen_dp1=0, dist_rx1=0, dist_tx1=0, dist_dp1=0; uint64_t fat_hit1=0, fat_mis1=0, fat_evc1=0; static uint64_t cb1[RTE_MAX_LCORE], ci1[RTE_MAX_LCORE]; unsigned seconds_seen=0; const bool seq_on=g_seq_on; uint64_t sink1[MAX_SINKS]={0}, txq_sum=0, txq_samples=0; unsigned txq_max=0; seq_stats sq1; memset(&sq1,0,sizeof(sq1)); long long lost_hwm=0; unsigned last_moves=0, polls=0; uint64_t rop1[RING_KIND_COUNT]={0}, rob1[RING_KIND_COUNT]={0}; FILE *csv=open_csv("/var/log/software-packet-distributor/worker_stats_v105.csv"); while(!g_quit){ rte_delay_us_block(HEALTH_POLL_US); health_tick(); if(++polls < 100000u/HEALTH_POLL_US) continue; polls=0; if(g_egress_mode==EGRESS_SINK){ for(unsigned wi=0; wi<NB_WORKERS; wi++){ unsigned c=rte_ring_count(g_tx_rings[wi]); txq_sum+=c; if(c>txq_max) txq_max=c; } txq_samples+=NB_WORKERS; } uint64_t now=rte_get_tsc_cycles(); uint64_t delta=now-last_1s; if(delta<hz) continue; unsigned ticks=(unsigned)(delta/hz); double sec_1s=(double)ticks; last_1s += (uint64_t)ticks*hz; for(unsigned t=0;t<ticks;++t){ unsigned cur=seconds_seen+t+1u; unsigned sec_idx=(cur-1u)&7u; unsigned cycle_idx=(cur-1u)/8u; mutate_flows_chunk(sec_idx, cycle_idx);} seconds_seen+=ticks; time_t epoch=time(NULL); double wrx_sum=0,wtx_sum=0, wdp_sum=0; double rx_vals[16]; for(unsigned wi=0; wi<NB_WORKERS; wi++){ uint64_t rx_d=g_worker_rx[wi]-rx1[wi]; rx1[wi]=g_worker_rx[wi]; uint64_t tx_d=g_worker_tx[wi]-tx1[wi]; tx1[wi]=g_worker_tx[wi]; uint64_t dp_d=g_worker_drop[wi]-d1[wi]; d1[wi]=g_worker_drop[wi]; double rx_kpps=(sec_1s>0? (double)rx_d/sec_1s:0)/1e3; double tx_kpps=(sec_1s>0? (double)tx_d/sec_1s:0)/1e3; double dp_kpps=(sec_1s>0? (double)dp_d/sec_1s:0)/1e3; wrx_sum+=rx_kpps; wtx_sum+=tx_kpps; wdp_sum+=dp_kpps; rx_vals[wi]=rx_kpps; const unsigned lc=WORKERS[wi]; double util=lcore_util_pct(lc, &cb1[lc], &ci1[lc]); PERF_LOG("[perf] w%02u rx=%.2f Kpps tx=%.2f Kpps drop=%.2f Kpps flows=%u util=%.1f%%%s%s", lc, rx_kpps, tx_kpps, dp_kpps, (unsigned)g_flow_count_shadow[wi], util, worker_usable(wi)? "":" state=", worker_usable(wi)? "":worker_health_name(wi)); if(csv){ fprintf(csv, "%ld,%u,%.3f,%.3f,%.3f,%u,%llu,%llu,%llu,%.1f", (long)epoch, lc, rx_kpps, tx_kpps, dp_kpps, (unsigned)g_flow_count_shadow[wi], (unsigned long long)(g_fat_hits - fat_hit1), (unsigned long long)(g_fat_misses - fat_mis1), (unsigned long long)(g_fat_evictions - fat_evc1), util); fputc('\n', csv);} } uint64_t gtx_d=g_gen_tx-gen_tx1; gen_tx1=g_gen_tx; uint64_t gdp_d=g_gen_drop-gen_dp1; gen_dp1=g_gen_drop; uint64_t drx_d=g_dist_rx-dist_rx1; dist_rx1=g_dist_rx; uint64_t dtx_d=g_dist_tx-dist_tx1; dist_tx1=g_dist_tx; uint64_t ddp_d=g_dist_drop-dist_dp1; dist_dp1=g_dist_drop; double gen_tx_mpps=(sec_1s>0? (double)gtx_d/sec_1s:0)/1e6; double gen_dp_mpps=(sec_1s>0? (double)gdp_d/sec_1s:0)/1e6; double dist_rx_mpps=(sec_1s>0? (double)drx_d/sec_1s:0)/1e6; double dist_tx_mpps=(sec_1s>0? (double)dtx_d/sec_1s:0)/1e6; double dist_dp_mpps=(sec_1s>0? (double)ddp_d/sec_1s:0)/1e6; PERF_LOG("[perf] gen tx=%.2f Mpps drop=%.2f Mpps", gen_tx_mpps, gen_dp_mpps); PERF_LOG("[perf] dist rx=%.2f Mpps tx=%.2f Mpps drop=%.2f Mpps", dist_rx_mpps, dist_tx_mpps, dist_dp_mpps); PERF_LOG("[perf] util gen=%.1f%% distA=%.1f%% distB=%.1f%%", lcore_util_pct(GEN_CORE,&cb1[GEN_CORE],&ci1[GEN_CORE]), lcore_util_pct(DISTA_CORE,&cb1[DISTA_CORE],&ci1[DISTA_CORE]), lcore_util_pct(DISTB_CORE,&cb1[DISTB_CORE],&ci1[DISTB_CORE])); if(g_egress_mode==EGRESS_SINK){ uint64_t srx=0; double umax=0.0; char su[96]; int off=0; su[0]=0; for(unsigned k=0;k<g_nb_sinks;k++){ const unsigned sc=g_sink_cores[k]; srx+=g_sink_rx[k]-sink1[k]; sink1[k]=g_sink_rx[k]; double u=lcore_util_pct(sc,&cb1[sc],&ci1[sc]); if(u>umax) umax=u; if(off<(int)sizeof(su)) off+=snprintf(su+off, sizeof(su)-(size_t)off, "%s%u:%.1f%%", k?",":"", sc, u); } double qavg=txq_samples? (double)txq_sum/(double)txq_samples:0.0; PERF_LOG("[perf] egress mode=sink sinks=%u rx=%.2f Mpps util=%s txq avg=%.0f max=%u/%u", g_nb_sinks, (sec_1s>0? (double)srx/sec_1s:0)/1e6, su, qavg, txq_max, RING_SIZE); if(umax>90.0 || (uint64_t)txq_max*4u>(uint64_t)RING_SIZE*3u) PERF_LOG("[egress] WARNING saturated: sink util=%.1f%% txq max=%u/%u (add SINK_CORES or use EGRESS=direct)", umax, txq_max, RING_SIZE); txq_sum=0; txq_samples=0; txq_max=0; } else { PERF_LOG("[perf] egress mode=direct (workers release mbufs in bulk)"); } uint64_t rop[RING_KIND_COUNT], rob[RING_KIND_COUNT]; double opp[RING_KIND_COUNT]; ring_ops_totals(rop, rob); for(unsigned k=0;k<RING_KIND_COUNT;k++){ uint64_t o=rop[k]-rop1[k], b=rob[k]-rob1[k]; opp[k]=b? (double)o/(double)b : 0.0; rop1[k]=rop[k]; rob1[k]=rob[k]; } PERF_LOG("[perf] ring ops/pkt ingress=%.3f pipe=%.3f worker=%.3f (enq+deq calls; fill=%u/%u/%u timeout=%u us zc=%s)", opp[RING_INGRESS], opp[RING_PIPE], opp[RING_WORKER], g_stage_fill[RING_INGRESS], g_stage_fill[RING_PIPE], g_stage_fill[RING_WORKER], (unsigned)g_stage_timeout_us, g_ring_zc?"on":"off"); double mean=wrx_sum/(double)NB_WORKERS; double var=0.0; for(unsigned wi=0; wi<NB_WORKERS; wi++){ double d=rx_vals[wi]-mean; var+=d*d; } var/=(double)NB_WORKERS; double sd=sqrt(var); PERF_LOG("[perf] workers rx stddev=%.2f Kpps", sd); double fmean=0.0; for(unsigned wi=0; wi<NB_WORKERS; wi++) fmean+=(double)g_flow_count_shadow[wi]; fmean/=(double)NB_WORKERS; double fvar=0.0; for(unsigned wi=0; wi<NB_WORKERS; wi++){ double fd=(double)g_flow_count_shadow[wi]-fmean; fvar+=fd*fd; } fvar/=(double)NB_WORKERS; double fsd=sqrt(fvar); PERF_LOG("[perf] workers flows stddev=%.2f", fsd); uint64_t fat_hit_d=g_fat_hits-fat_hit1; fat_hit1=g_fat_hits; uint64_t fat_mis_d=g_fat_misses-fat_mis1; fat_mis1=g_fat_misses; uint64_t fat_evc_d=g_fat_evictions-fat_evc1; fat_evc1=g_fat_evictions; double hits_M=(double)fat_hit_d/1e6; double mis_M=(double)fat_mis_d/1e6; double evc_M=(double)fat_evc_d/1e6; PERF_LOG("[perf] FAT hits=%.2fM misses=%.2fM evictions=%.2fM", hits_M, mis_M, evc_M); if(seq_on){ seq_stats sq; sq.in_order=g_seq.in_order; sq.reordered=g_seq.reordered; sq.dup=g_seq.dup; sq.gaps=g_seq.gaps; sq.late=g_seq.late; unsigned long long hd[SEQ_HIST_BUCKETS]; for(unsigned b=0;b<SEQ_HIST_BUCKETS;b++){ sq.hist[b]=g_seq.hist[b]; hd[b]=(unsigned long long)(sq.hist[b]-sq1.hist[b]); } /* gaps - late is only final once late packets have had a chance to arrive: report new highs of the cumulative figure, never a negative delta. */ long long lost_cum=(long long)sq.gaps-(long long)sq.late, lost=0; if(lost_cum>lost_hwm){ lost=lost_cum-lost_hwm; lost_hwm=lost_cum; } PERF_LOG("[seq] epoch=%u reta_moves=%u fat_evictions=%llu in_order=%llu reordered=%llu dup=%llu lost=%lld lost_total=%lld dist 1:%llu 2:%llu 4:%llu 8:%llu 16:%llu 32:%llu 64:%llu 128+:%llu", (unsigned)g_epoch, last_moves, (unsigned long long)fat_evc_d, (unsigned long long)(sq.in_order-sq1.in_order), (unsigned long long)(sq.reordered-sq1.reordered), (unsigned long long)(sq.dup-sq1.dup), lost, lost_hwm, hd[0], hd[1], hd[2], hd[3], hd[4], hd[5], hd[6], hd[7]); sq1=sq; } g_epoch += ticks; for(unsigned wi=0; wi<NB_WORKERS; wi++){ g_flow_count_shadow[wi]=g_flow_count[wi]; g_flow_count[wi]=0; } unsigned moves=greedy_enabled()? greedy_reshaper_tick(rx_vals, 8u):0u; printf("[reta] greedy moves=%u", moves); putchar('\n'); last_moves=moves; if(csv){ fflush(csv);} } if(csv) fclose(csv); return 0; }
@@ -0,0 +1,22 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#include "seqchk.h"
+volatile seq_stats g_seq; bool g_seq_on=false;
+static seq_state *g_seq_tab=NULL; static uint32_t g_seq_mask=0;
+static inline bool seq_check_enabled_impl(void){ const char *s=getenv("SEQ_CHECK"); if(!s) return false; return strcasecmp(s,"on")==0; }
+bool seq_check_enabled(void){ return seq_check_enabled_impl(); }
+uint32_t seq_flows_from_env(void){ const char *s=getenv("SEQ_FLOWS"); if(s && s[0]){ char *end=NULL; unsigned long v=strtoul(s,&end,0); if(end!=s && v>=1024ul && v<=(1ul<<26)) return (uint32_t)rte_align32pow2((uint32_t)v); } return 1u<<20; }
+void seq_init(uint32_t flows){ g_seq_tab=(seq_state*)rte_zmalloc_socket("seq_tab", (size_t)flows*sizeof(seq_state), RTE_CACHE_LINE_SIZE, rte_socket_id()); if(!g_seq_tab) rte_exit(EXIT_FAILURE, "sequence table allocate failed: %s", rte_strerror(rte_errno)); g_seq_mask=flows-1u; g_seq_on=true; }
+void seq_fini(void){ rte_free(g_seq_tab); g_seq_tab=NULL; g_seq_mask=0; g_seq_on=false; }
+static inline uint32_t rd32(const uint8_t *p){ return ((uint32_t)p[0]<<24) | ((uint32_t)p[1]<<16) | ((uint32_t)p[2]<<8) | p[3]; }
+static inline unsigned dist_bucket(uint32_t d){ unsigned b=31u-(unsigned)__builtin_clz(d); return b<SEQ_HIST_BUCKETS? b : SEQ_HIST_BUCKETS-1u; }
+/* Anti-replay style window: ahead of max -> in order (gap = provisional loss); inside window -> dup or late fill; older -> late. */
+static inline void seq_update(seq_state *s, uint32_t flow, uint32_t seq, seq_stats *acc){ if(unlikely(s->flow!=flow || s->max==0u)){ s->flow=flow; s->max=seq; s->win=1u; acc->in_order++; return; } if(likely(seq>s->max)){ uint32_t gap=seq-s->max; acc->gaps+=gap-1u; s->win=(gap>=SEQ_WINDOW)? 1u : ((s->win<<gap)|1u); s->max=seq; acc->in_order++; return; } uint32_t d=s->max-seq; if(d<SEQ_WINDOW){ uint64_t bit=1ull<<d; if(s->win & bit){ acc->dup++; return; } s->win|=bit; } acc->late++; acc->reordered++; acc->hist[dist_bucket(d)]++; }
+static inline void seq_publish(const seq_stats *acc){ g_seq.in_order+=acc->in_order; g_seq.reordered+=acc->reordered; g_seq.dup+=acc->dup; g_seq.gaps+=acc->gaps; g_seq.late+=acc->late; for(unsigned b=0;b<SEQ_HIST_BUCKETS;b++) g_seq.hist[b]+=acc->hist[b]; }
+void seq_check_frame(const uint8_t *p, seq_stats *acc){ uint32_t flow=rd32(p+SEQ_STAMP_OFF), seq=rd32(p+SEQ_STAMP_OFF+4); if(unlikely(seq==0u)) return; seq_update(&g_seq_tab[flow & g_seq_mask], flow, seq, acc); }
+/* Two passes per chunk: pull stamps and prefetch table slots, then update, so a large table costs ~one overlapped miss per packet. */
+void seq_check_burst(struct rte_mbuf **pkts, unsigned n){ if(unlikely(!g_seq_tab)) return; seq_stats acc; memset(&acc,0,sizeof(acc)); uint32_t fl[BURST], sq[BURST]; for(unsigned base=0; base<n; base+=BURST){ unsigned cnt=RTE_MIN(n-base, (unsigned)BURST); for(unsigned i=0;i<cnt;i++){ struct rte_mbuf *m=pkts[base+i]; if(likely(i+4u<cnt)) rte_prefetch0(rte_pktmbuf_mtod_offset(pkts[base+i+4u], void*, SEQ_STAMP_OFF)); if(unlikely(m->data_len<WIRE_BYTES)){ sq[i]=0; continue; } const uint8_t *s=rte_pktmbuf_mtod_offset(m, const uint8_t*, SEQ_STAMP_OFF); fl[i]=rd32(s); sq[i]=rd32(s+4); rte_prefetch0(&g_seq_tab[fl[i] & g_seq_mask]); } for(unsigned i=0;i<cnt;i++){ if(unlikely(sq[i]==0u)) continue; seq_update(&g_seq_tab[fl[i] & g_seq_mask], fl[i], sq[i], &acc); } } seq_publish(&acc); }
@@ -0,0 +1,15 @@
+/*
+ * software-packet-distributor
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2026 Mike Chang
+ * Author: Mike Chang <mikechang.engr@gmail.com>
+ */
+#include "stage.h"
+#include "globals.h"
+ring_ops g_ring_ops[RTE_MAX_LCORE];
+unsigned g_stage_fill[RING_KIND_COUNT]={STAGE_DEFAULT_FILL_BURST, STAGE_DEFAULT_FILL_BURST, STAGE_DEFAULT_FILL_WORKER}; uint64_t g_stage_timeout=0; uint32_t g_stage_timeout_us=STAGE_DEFAULT_TIMEOUT_US; bool g_ring_zc=false;
+/* STAGE_FILL=<n> for every ring or <ingress>,<pipe>,<worker> (1..256 objects each), STAGE_TIMEOUT_US=0..10000 (0: flush at the end of every burst), RING_ZC=on. */
+void stage_config_from_env(void){ const char *s=getenv("STAGE_FILL"); g_stage_fill[RING_INGRESS]=g_stage_fill[RING_PIPE]=STAGE_DEFAULT_FILL_BURST; g_stage_fill[RING_WORKER]=STAGE_DEFAULT_FILL_WORKER; if(s && s[0]){ unsigned v3[RING_KIND_COUNT], n=0; for(; n<RING_KIND_COUNT && *s; n++){ char *end=NULL; unsigned long v=strtoul(s,&end,0); if(end==s || v<1ul || v>STAGE_CAP) break; v3[n]=(unsigned)v; s=end; if(*s==',') s++; } if(n==1u && !*s){ for(unsigned k=0;k<RING_KIND_COUNT;k++) g_stage_fill[k]=v3[0]; } else if(n==RING_KIND_COUNT && !*s){ memcpy(g_stage_fill, v3, sizeof(v3)); } else puts("[stage] STAGE_FILL must be <n> or <ingress>,<pipe>,<worker>, each 1..256; using defaults"); } s=getenv("STAGE_TIMEOUT_US"); g_stage_timeout_us=STAGE_DEFAULT_TIMEOUT_US; if(s && s[0]){ char *end=NULL; unsigned long v=strtoul(s,&end,0); if(end!=s && v<=STAGE_MAX_TIMEOUT_US) g_stage_timeout_us=(uint32_t)v; } g_stage_timeout=(uint64_t)g_stage_timeout_us*rte_get_tsc_hz()/1000000ull; s=getenv("RING_ZC"); g_ring_zc=(s && strcasecmp(s,"on")==0); if(g_ring_zc && !STAGE_HAVE_ZC){ puts("[stage] RING_ZC needs DPDK >= 20.11 built with ALLOW_EXPERIMENTAL_API; using copy enqueue/dequeue"); g_ring_zc=false; } }
+void stage_init(stage_buf *b, struct rte_ring *r, unsigned kind){ memset(b, 0, offsetof(stage_buf, obj)); b->ring=r; b->fill=g_stage_fill[kind]; b->ops=&g_ring_ops[rte_lcore_id()]; }
+/* Calls per ring kind, both sides (ingress: gen enq + Dist-A deq; pipe: Dist-A enq + Dist-B deq; worker: Dist-B enq + worker deq). */
+void ring_ops_totals(uint64_t *ops, uint64_t *objs){ const ring_ops *g=&g_ring_ops[GEN_CORE], *a=&g_ring_ops[DISTA_CORE], *b=&g_ring_ops[DISTB_CORE]; ops[RING_INGRESS]=g->enq+a->deq; objs[RING_INGRESS]=g->objs; ops[RING_PIPE]=a->enq+b->deq; objs[RING_PIPE]=a->objs; uint64_t wd=0; for(unsigned i=0;i<NB_WORKERS;i++) wd+=g_ring_ops[WORKERS[i]].deq; ops[RING_WORKER]=b->enq+wd; objs[RING_WORKER]=b->objs; }